@@ -1,7 +1,12 @@
 #include "application.h"
 
+#include <algorithm>
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <limits>
 #include <memory>
+#include <sstream>
 #include <chrono>
 
 #ifndef _GLIBCXX_HAS_GTHREADS
@@ -14,63 +19,112 @@
 #include "3rdparty/stb_image.h"
 #include "glad/glad.h"
 
+#include "benchmark.h"
+#include "headlesscontext.h"
 #include "utils/constants.h"
 #include "utils/utils.h"
 #include "utils/random.h"
 #include "terrain/heightmapprovider.h"
 #include "settings.h"
-#include "graphics//textureloader.h"
+#include "graphics/assetloader.h"
+#include "graphics/glstate.h"
+#include "graphics/pngwriter.h"
+#include "graphics/linebatch.h"
 #include "utils/drawcalltrack.h"
 #include "utils/resourcemanager.h"
+#include "utils/profiler.h"
 
 
-Application::Application(GLFWwindow* window)
+// headless runs without a benchmark or captures stop after this long
+constexpr double DefaultHeadlessSecs = 10;
+
+Application::Application(GLFWwindow* window, const RunOptions& options)
     : m_window(window)
+    , m_benchmark(options.benchmark)
+    , m_headless(options.headless)
+    , m_captures(options.captures)
     , m_chunkManager(m_frustrum)
     , m_config(Settings::get())
 {
+    Profiler::get().setThreadName("main");
+
+    if (!m_headless)
+        m_captures.clear(); // read back from the offscreen target only
+    std::sort(m_captures.begin(), m_captures.end());
+    m_runLength = m_benchmark ? m_benchmark->getDuration()
+                : m_headless  ? (m_captures.empty() ? DefaultHeadlessSecs : 0)
+                : std::numeric_limits<double>::infinity();
+    if (!m_captures.empty())
+        m_runLength = std::max<double>(m_runLength, m_captures.back());
+
+    if (m_headless)
+    {
+        m_config.rendering().vsync = false;
+        m_config.rendering().fpsLimit = 0;
+        // captures are compared across runs and machines: a fixed world, streamed
+        // and lit the same way whatever the frame cost
+        if (m_config.world().seed == 0)
+            m_config.world().seed = 1;
+        m_chunkManager.setDeterministic(true);
+    }
+    if (m_benchmark)
+    {
+        // same world every run, frames as fast as they come
+        m_config.world().seed = m_benchmark->getSeed();
+        m_config.rendering().vsync = false;
+        m_config.rendering().fpsLimit = 0;
+    }
     initGL();
     registerCallbacks();
-    Random::init();
+    Random::init(m_benchmark || m_headless ? m_config.world().seed : 0);
     HeightMapProvider::init(m_config.world().seed == 0 ? std::time(nullptr) : m_config.world().seed);
 
-    std::unique_ptr<Shader> shader = std::make_unique<Shader>();
-    shader->load(ShaderFiles::vertex_shader_chunk, ShaderFiles::fragment_shader_chunk);
-    shader->use();
-    shader->setInt("blockTexture", 0);
-    ResourceManager::shaders().insert("chunk", std::move(shader));
-
-    shader = std::make_unique<Shader>();
-    shader->load(ShaderFiles::vertex_shader_skybox, ShaderFiles::fragment_shader_skybox);
-    shader->use();
-    shader->setInt("skybox", 0);
-    ResourceManager::shaders().insert("skybox", std::move(shader));
-
-    shader = std::make_unique<Shader>();
-    shader->load("shaders/ui2d_vs.glsl", "shaders/ui2d_fs.glsl");
-    shader->use();
-    shader->setInt("tex", 0);
-    ResourceManager::shaders().insert("crosshair", std::move(shader));
-
-    shader = std::make_unique<Shader>("shaders/outline_vs.glsl", "shaders/outline_fs.glsl");
-    ResourceManager::shaders().insert("outline", std::move(shader));
-
-    ResourceManager::textures().insert("blocks", TextureLoader::loadTexture(m_config.world().blockTextureName));
-    ResourceManager::textures().insert("skybox", TextureLoader::loadCubeMap(m_config.skyboxNames(), false));
-    ResourceManager::textures().insert("crosshair", TextureLoader::loadTexture("textures/crosshair.png"));
+    // shader sources and images are read on the workers while the GL objects are
+    // created here, in whatever order the files come in
+    auto bindSampler = [](const char* name)
+    {
+        return [name](Shader& shader)
+        {
+            shader.use();
+            shader.setInt(name, 0);
+        };
+    };
+    AssetLoader assets;
+    assets.addShader("chunk", ShaderFiles::vertex_shader_chunk, ShaderFiles::fragment_shader_chunk,
+                     "", bindSampler("blockTexture"));
+    assets.addShader("chunk_translucent", ShaderFiles::vertex_shader_chunk, ShaderFiles::fragment_shader_chunk,
+                     "#define TRANSLUCENT\n", bindSampler("blockTexture"));
+    assets.addShader("skybox", ShaderFiles::vertex_shader_skybox, ShaderFiles::fragment_shader_skybox,
+                     "", bindSampler("skybox"));
+    assets.addShader("crosshair", "shaders/ui2d_vs.glsl", "shaders/ui2d_fs.glsl", "", bindSampler("tex"));
+    assets.addShader("lines", "shaders/lines_vs.glsl", "shaders/lines_fs.glsl");
+    assets.addShader("entity", "shaders/entity_vs.glsl", "shaders/entity_fs.glsl", "", bindSampler("blockTexture"));
+    assets.addTextureArray("blocks", m_config.world().blockTextureName);
+    assets.addCubeMap("skybox", m_config.skyboxNames(), false);
+    assets.addTexture("crosshair", "textures/crosshair.png");
+    assets.run();
+    assets.printTimeline(std::cout);
 
     m_skyBox.initialize();
     m_skyBox.setShader(ResourceManager::shaders().get("skybox"));
     m_crosshair.initialize();
     m_crosshair.setShader(ResourceManager::shaders().get("crosshair"));
+    LineBatch::get().initialize();
+    m_gpuTimer.initialize();
+    m_frameGraph.initialize();
+    m_frameGraph.setShader(ResourceManager::shaders().get("lines"));
+    m_frameGraph.setRecorder(&m_frames);
+    m_frames.setHitchThreshold(m_config.rendering().hitchMs);
+    LineBatch::get().setShader(ResourceManager::shaders().get("lines"));
+    m_entities.initialize();
+    m_entities.setShader(ResourceManager::shaders().get("entity"));
+    m_entities.setTexture(ResourceManager::textures().get("blocks"));
     m_chunkManager.setShader(ResourceManager::shaders().get("chunk"));
+    m_chunkManager.setTranslucentShader(ResourceManager::shaders().get("chunk_translucent"));
     m_chunkManager.setTexture(ResourceManager::textures().get("blocks"));
     m_skyBox.setTexture(ResourceManager::textures().get("skybox"));
     m_crosshair.setTexture(ResourceManager::textures().get("crosshair"));
 
-    m_fpsCounter.setContext(m_window);
-    m_info.setContext(m_window);
-
     Utils::glCheckError();
 
     m_player.setControl(std::make_unique<WalkingControl>());
@@ -78,37 +132,62 @@ Application::Application(GLFWwindow* window)
     m_player.setWorldData(&m_chunkManager);
     m_player.setPosition({Random::intInRange(-100, 100), 100, Random::intInRange(-100, 100)});
     m_player.setDirection({0, 0, 1});
+    if (m_benchmark)
+    {
+        if (m_benchmark->getControl() == Benchmark::Flying)
+            m_player.setControl(std::make_unique<FlyingControl>());
+        else if (m_benchmark->getControl() == Benchmark::WalkingAABB)
+            m_player.setControl(std::make_unique<WalkingControl>(WalkingControl::VoxelAABB));
+        Benchmark::Key start = m_benchmark->sample(0);
+        m_player.setPosition(start.pos);
+        m_player.setRotation(start.yaw, start.pitch);
+    }
 
     resizeCallback(m_config.rendering().width, m_config.rendering().height);
 }
 
 void Application::initGL()
 {
-    int w, h;
-    glfwGetWindowSize(m_window, &w, &h);
-    updateProjectionMatrix(w, h);
-
-    if (!m_window)
+    if (!m_window && !m_headless)
         onError("glfwCreateWindow failed");
 
-    glfwSetWindowUserPointer(m_window, (void*)this);
-    glfwMakeContextCurrent(m_window);
+    GLADloadproc loader = m_window ? (GLADloadproc) glfwGetProcAddress
+                                   : (GLADloadproc) HeadlessContext::getProcAddress;
+    if (m_window)
+    {
+        glfwSetWindowUserPointer(m_window, (void*)this);
+        glfwMakeContextCurrent(m_window);
+    }
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress))
+    if (!gladLoadGLLoader(loader))
         onError("gladLoadGLLoader failed");
+    Shader::initBinaryCache(loader);
+
+    if (m_window)
+    {
+        glfwSwapInterval(m_config.rendering().vsync ? 1 : 0);
+        glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwGetCursorPos(m_window, &m_xprev, &m_yprev);
+    }
+    // there is no default framebuffer, everything goes in here
+    else if (!m_offscreen.create(m_config.rendering().width, m_config.rendering().height))
+        onError("offscreen framebuffer incomplete");
 
-    glfwSwapInterval(m_config.rendering().vsync ? 1 : 0);
-    glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwGetCursorPos(m_window, &m_xprev, &m_yprev);
+    int w, h;
+    getFramebufferSize(w, h);
+    updateProjectionMatrix(w, h);
 
     glClearColor(0.1f, 0.2f, 0.4f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
+    GLState::setEnabled(GL_DEPTH_TEST, true);
+    GLState::setEnabled(GL_CULL_FACE, true);
 //    glCullFace(GL_FRONT);
 }
 
 void Application::registerCallbacks()
 {
+    if (!m_window)
+        return;
+
     glfwSetKeyCallback(m_window, [](GLFWwindow* w, int key, int /*scancode*/, int action, int /*mods*/)
     {
         Application* This = (Application*)glfwGetWindowUserPointer(w);
@@ -123,6 +202,11 @@ void Application::registerCallbacks()
         Application* This = (Application*)glfwGetWindowUserPointer(w);
         This->cursorPosCallback(xpos, ypos);
     });
+    glfwSetMouseButtonCallback(m_window, [](GLFWwindow* w, int button, int action, int /*mods*/)
+    {
+        Application* This = (Application*)glfwGetWindowUserPointer(w);
+        This->mouseButtonCallback(button, action);
+    });
     glfwSetFramebufferSizeCallback(m_window, [](GLFWwindow* w, int width, int height)
     {
         Application* This = (Application*)glfwGetWindowUserPointer(w);
@@ -146,9 +230,37 @@ void Application::keyCallback(int key, int action)
         m_player.setControl(std::make_unique<FlyingControl>());
     if (key == GLFW_KEY_F2 && action == GLFW_PRESS)
         m_player.setControl(std::make_unique<WalkingControl>());
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+        m_player.setControl(std::make_unique<WalkingControl>(WalkingControl::VoxelAABB));
+#ifdef DEBUG_DRAW
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+        m_drawChunkBounds = !m_drawChunkBounds;
+#endif
+    if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+    {
+        Profiler::get().setEnabled(!Profiler::isEnabled());
+        if (!Profiler::isEnabled())
+        {
+            m_info.setProfileInfo({});
+            m_info.setGpuInfo({}, true);
+        }
+    }
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+    {
+        if (Profiler::get().writeChromeTrace("profile_trace.json", m_gpuTimer.getEvents(), "GPU"))
+            std::cout << "Profile written to profile_trace.json" << std::endl;
+    }
+    if (key == GLFW_KEY_G && action == GLFW_PRESS)
+        spawnEntities(1000);
+    if (key == GLFW_KEY_H && action == GLFW_PRESS)
+        m_entities.clear();
+    // block to place: 1..8 follow Blocks::Type
+    if (key >= GLFW_KEY_1 && key <= GLFW_KEY_8 && action == GLFW_PRESS)
+        m_placeBlock = key - GLFW_KEY_1 + 1;
     if (key == GLFW_KEY_GRAVE_ACCENT && action == GLFW_PRESS) {
         m_fpsCounter.toggleActive();
         m_info.toggleActive();
+        m_frameGraph.toggleActive();
     }
 }
 
@@ -158,7 +270,16 @@ void Application::cursorPosCallback(double x, double y)
     double dy = y - m_yprev;
     m_xprev = x;
     m_yprev = y;
-    m_player.rotate(dx / 10, -dy / 10);
+    if (!m_benchmark)
+        m_player.rotate(dx / 10, -dy / 10);
+}
+
+void Application::mouseButtonCallback(int button, int action)
+{
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+        m_player.breakBlock();
+    if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
+        m_player.placeBlock(m_placeBlock);
 }
 
 void Application::resizeCallback(int width, int height)
@@ -167,61 +288,250 @@ void Application::resizeCallback(int width, int height)
     glViewport(0, 0, width, height);
     m_crosshair.setTransform(glm::ortho(0.0f, (float)width, 0.0f, (float)height));
     m_crosshair.setPosition(width / 2 - 8, height / 2 - 8);
+    m_fpsCounter.setViewportSize(width, height);
+    m_info.setViewportSize(width, height);
+    m_frameGraph.setViewportSize(width, height);
 }
 
 void Application::run()
 {
     m_timerMain.restart();
     m_timerFpsCap.restart();
+    m_runClock.restart();
+    bool firstFrame = true;
+    if (m_benchmark)
+        m_benchmark->start();
 
-    while (!glfwWindowShouldClose(m_window))
+    while (!shouldClose())
     {
-        m_timeSlice += m_timerMain.getElapsedSecs();
+        double time = runTime();
+        if (m_nextCapture == m_captures.size() && time >= m_runLength)
+            break;
+
+        // headless frames are fixed steps so that captures land on the same frames every run
+        m_timeSlice += m_headless ? Consts::FIXED_TIMESTEP : m_timerMain.getElapsedSecs();
         m_timerMain.restart();
 
+        double frameCost = m_timerFpsCap.getElapsedSecs();
+        double targetFrameTime = Consts::FIXED_TIMESTEP;
+        double slept = 0;
+
         if(m_config.rendering().fpsLimit > 0 &&
            m_config.rendering().vsync == false)
         {
-            double dt = m_timerFpsCap.getElapsedSecs();
-            double wait = 1.0 / m_config.rendering().fpsLimit - dt;
+            targetFrameTime = 1.0 / m_config.rendering().fpsLimit;
+            double wait = targetFrameTime - frameCost;
 
             if (wait > 0)
+            {
+                Timer sleepTimer;
                 std::this_thread::sleep_for(std::chrono::duration<double>(wait));
-
-            m_timerFpsCap.restart(); // must not count sleep time
+                slept = sleepTimer.getElapsedSecs();
+            }
         }
+        m_timerFpsCap.restart(); // must not count sleep time
 
-        pollEvents();
+        // the previous frame's work and the sleep that padded it
+        if (!firstFrame)
+            m_frames.record(frameCost, slept);
+        firstFrame = false;
 
-        for (; m_timeSlice > Consts::FIXED_TIMESTEP;
-               m_timeSlice -= Consts::FIXED_TIMESTEP)
+        // streaming gets what is left of the frame after everything else
+        m_chunkManager.streamingBudget().beginFrame(targetFrameTime, frameCost);
+
+        // Frame stages, in order:
+        // 1. input
+        pollEvents();
+        if (m_benchmark && m_benchmark->getControl() == Benchmark::Flying)
+            followBenchmarkPath(time);
+        if (m_benchmark)
+            spawnEntities(m_benchmark->entitiesToSpawn(time));
+
+        // 2. physics, fixed-step. Catch-up is capped, backlog beyond that is dropped
+        //    so that one long frame can't make the following ones long as well
+        int steps = 0;
+        for (; m_timeSlice > Consts::FIXED_TIMESTEP && steps < Consts::MAX_STEPS_PER_FRAME;
+               m_timeSlice -= Consts::FIXED_TIMESTEP, steps++)
             update(Consts::FIXED_TIMESTEP);
 
+        if (m_timeSlice > Consts::FIXED_TIMESTEP)
+            m_timeSlice = 0;
+
+        // 3. world streaming, once per frame, around the post-physics player position
+        updateWorld();
+
+        // 4. rendering
+        m_chunkManager.setAnimationTime(time);
         render();
-        m_fpsCounter.tick();
+        captureFrames(time);
+        m_fpsCounter.tick(m_frames);
+
+        if (Profiler::isEnabled())
+        {
+            Profiler::get().endFrame();
+            m_info.setProfileInfo(Profiler::get().getFrameStats());
+            m_info.setGpuInfo(m_gpuTimer.getPassStats(), m_gpuTimer.isSupported());
+        }
+        m_frameIndex++;
+    }
+
+    FrameRecorder::Summary frame = m_frames.getFrameSummary();
+    std::cout << "Frame ms over the last " << m_frames.getRecentCount() << " frames: p50 " << frame.p50
+              << ", p95 " << frame.p95 << ", p99 " << frame.p99 << ", max " << frame.max << "; "
+              << m_frames.getHitchCount() << " hitches in total" << std::endl;
+    if (m_frames.writeCsv("frame_times.csv"))
+        std::cout << "Frame times written to frame_times.csv" << std::endl;
+
+    if (m_headless)
+    {
+        double wall = m_runClock.getElapsedSecs();
+        FrameRecorder::Summary run = m_frames.getRunFrameSummary();
+        std::cout << "Headless: " << m_frameIndex << " frames (" << runTime() << " s run time) in "
+                  << wall << " s, " << wall * 1000 / std::max(1, m_frameIndex) << " ms / frame; frame ms p50 "
+                  << run.p50 << ", p95 " << run.p95 << ", p99 " << run.p99 << ", max " << run.max << std::endl;
+    }
+
+    if (m_benchmark)
+    {
+        size_t peakMemory = Utils::getPeakMemoryBytes();
+        m_benchmark->report(std::cout, m_frames, m_chunkManager.getLoadLatencies(), peakMemory);
+        std::ofstream results("benchmark_results.txt");
+        m_benchmark->report(results, m_frames, m_chunkManager.getLoadLatencies(), peakMemory);
+    }
+}
+
+void Application::followBenchmarkPath(double time, float dt_sec)
+{
+    Benchmark::Key key = m_benchmark->sample(time);
+    if (m_benchmark->getControl() == Benchmark::Flying)
+    {
+        m_player.setPosition(key.pos);
+        m_player.setRotation(key.yaw, key.pitch);
+        return;
+    }
+
+    // walkers head for the path at walking speed and may fall behind it,
+    // collisions decide where they end up
+    const glm::vec3& pos = m_player.getPosition();
+    glm::vec3 offset = key.pos - pos;
+    offset.y = 0;
+    float distance = glm::length(offset);
+    m_benchmark->addPathDistance(distance);
+
+    // less than half of the last step made, most likely stopped by a step up
+    glm::vec3 moved = pos - m_walkFrom;
+    moved.y = 0;
+    bool stuck = m_walkStep > 0 && glm::length(moved) < m_walkStep * 0.5f;
+    m_walkFrom = pos;
+    m_walkStep = std::min(distance, Consts::WALK_SPEED * dt_sec);
+    if (distance < 0.01f)
+        return;
+    m_player.setRotation(glm::degrees(std::atan2(offset.z, offset.x)), key.pitch);
+    m_player.move(AbstractPlayerControl::Forward, m_walkStep);
+    if (stuck)
+        m_player.jump();
+}
+
+void Application::captureFrames(double time)
+{
+    if (m_nextCapture == m_captures.size() || m_captures[m_nextCapture] > time)
+        return;
+
+    std::vector<uint8_t> pixels;
+    m_offscreen.readPixels(pixels);
+    // times that fell between two frames get the later one
+    for (; m_nextCapture < m_captures.size() && m_captures[m_nextCapture] <= time; m_nextCapture++)
+    {
+        std::stringstream file;
+        file << "capture_" << std::setw(6) << std::setfill('0') << (int)(m_captures[m_nextCapture] * 1000 + 0.5f) << "ms.png";
+        if (PngWriter::write(file.str(), m_offscreen.width(), m_offscreen.height(), pixels.data()))
+            std::cout << "Frame " << m_frameIndex << " captured to " << file.str() << std::endl;
+        else
+            std::cerr << "Can't write " << file.str() << std::endl;
+    }
+}
+
+double Application::runTime() const
+{
+    return m_headless ? m_frameIndex * Consts::FIXED_TIMESTEP : m_runClock.getElapsedSecs();
+}
+
+bool Application::shouldClose() const
+{
+    return m_window && glfwWindowShouldClose(m_window);
+}
+
+void Application::getFramebufferSize(int& width, int& height) const
+{
+    if (m_window)
+        glfwGetFramebufferSize(m_window, &width, &height);
+    else
+    {
+        width = m_offscreen.width();
+        height = m_offscreen.height();
     }
 }
 
 void Application::pollEvents()
 {
-    glfwPollEvents();
+    if (m_window)
+        glfwPollEvents();
 }
 
 void Application::update(float dt_sec)
 {
-    handleKbd(dt_sec);
+    PROFILE_ZONE("Application::update");
+    if (!m_benchmark && m_window)
+        handleKbd(dt_sec);
+    // walkers are steered per tick, their movement is consumed by the tick
+    bool benchmarkWalk = m_benchmark && m_benchmark->getControl() != Benchmark::Flying;
+    if (benchmarkWalk)
+        followBenchmarkPath(runTime(), dt_sec);
+    m_player.update(dt_sec);
+    if (benchmarkWalk)
+        m_benchmark->addCollisionTime(m_player.getCollisionTimeMs());
+    int entities = m_entities.count();
+    m_entities.update(m_chunkManager, dt_sec);
+    if (m_benchmark && entities > 0)
+        m_benchmark->addEntityStep(entities, m_entities.getStepTimeMs());
+    m_chunkManager.simulate(dt_sec);
+}
+
+void Application::updateWorld()
+{
+    PROFILE_ZONE("Application::updateWorld");
     const glm::vec3& camDir = m_camera.getDirection();
     const glm::vec3& playerPos = m_player.getPosition();
     m_chunkManager.update({(int)playerPos.x, (int)playerPos.y, (int)playerPos.z});
-    m_player.update(dt_sec);
 
     m_info.setPositionInfo(playerPos.x, playerPos.y, playerPos.z);
     m_info.setViewDirectionInfo(camDir.x, camDir.y, camDir.z);
+    m_info.setEntityInfo(m_entities.count(), m_entities.getStepTimeMs(), m_entities.getEntitiesPerMs());
+    const BlockSimulation& simulation = m_chunkManager.simulation();
+    m_info.setSimulationInfo(simulation.getActiveCount(), simulation.getMovesLastStep(), simulation.getStepTimeMs());
+    const LightEngine& lighting = m_chunkManager.lighting();
+    m_info.setLightingInfo(lighting.getColumnTimeMs(), lighting.getQueuedJobs());
+    m_info.setMeshingInfo(m_chunkManager.getMeshTimeMs(), m_config.rendering().ambientOcclusion);
+}
+
+void Application::spawnEntities(int count)
+{
+    // falling blocks scattered above the player
+    const glm::vec3& center = m_player.getPosition();
+    for (int i = 0; i < count; i++)
+    {
+        glm::vec3 pos {center.x + Random::floatInRange(-16, 16),
+                       center.y + Random::floatInRange(5, 30),
+                       center.z + Random::floatInRange(-16, 16)};
+        glm::vec3 velocity {Random::floatInRange(-0.05f, 0.05f), 0, Random::floatInRange(-0.05f, 0.05f)};
+        auto block = Random::intInRange((int)Blocks::Type::Grass1, (int)Blocks::Type::Sand);
+        m_entities.spawn(pos, velocity, {0.25f, 0.25f, 0.25f}, block);
+    }
 }
 
 void Application::handleKbd(float dt)
 {
-    float dist = dt * 10;
+    float dist = dt * Consts::WALK_SPEED;
     if (glfwGetKey(m_window, GLFW_KEY_LEFT_SHIFT))
         dist *= 2.0f;
     else if (glfwGetKey(m_window, GLFW_KEY_LEFT_CONTROL))
@@ -239,37 +549,79 @@ void Application::handleKbd(float dt)
 
 void Application::render()
 {
+    PROFILE_ZONE("Application::render");
 #ifdef TRACK_GL_DRAWCALLS
     m_info.setDrawCallCount(DrawCallTrack::getDrawCallCount());
     m_info.setTriangleCount(DrawCallTrack::getTriangleCount());
+    m_info.setUniformSetCount(DrawCallTrack::getUniformSetCount(), DrawCallTrack::getRedundantUniformSetCount());
+    m_info.setStateChangeCount(DrawCallTrack::getStateChangeCount(), DrawCallTrack::getSkippedStateChangeCount());
     DrawCallTrack::resetCount();
 #endif
+    const FrameBudget& budget = m_chunkManager.streamingBudget();
+    m_info.setStreamingInfo(budget.getSpentLastFrameSecs() * 1000, budget.getBudgetSecs() * 1000);
+
     updateFrustrum();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     m_view = m_camera.getViewMatrix();
 
     m_chunkManager.setTransform(m_proj * m_view);
+    m_chunkManager.setCameraPosition(m_camera.getPosition());
+    m_entities.setTransform(m_proj * m_view);
     m_skyBox.setTransform(m_proj * glm::mat4(glm::mat3(m_view)));
-    Shader& outlineShader = ResourceManager::shaders().get("outline");
-    outlineShader.use();
-    outlineShader.setMat4("proj_view", &(m_proj * m_view)[0][0]);
+    LineBatch::get().setTransform(m_proj * m_view);
 
+    m_gpuTimer.beginFrame();
+    m_gpuTimer.begin("chunks");
     m_chunkManager.render();
+    m_gpuTimer.end();
+    m_gpuTimer.begin("entities");
+    m_entities.render();
+    m_gpuTimer.end();
+    m_gpuTimer.begin("skybox");
     m_skyBox.render();
-    m_fpsCounter.render();
-    m_info.render();
-    m_crosshair.render();
+    m_gpuTimer.end();
+    m_gpuTimer.begin("translucent");
+    m_chunkManager.renderTranslucent();
+    m_gpuTimer.end();
     m_player.render();
+#ifdef DEBUG_DRAW
+    if (m_drawChunkBounds)
+        m_chunkManager.drawDebug();
+#endif
+    m_gpuTimer.begin("lines");
+    LineBatch::get().render();
+    m_gpuTimer.end();
+    // timings on screen would make headless frames differ from run to run,
+    // they go to stdout instead
+    if (!m_headless)
+    {
+        m_gpuTimer.begin("text");
+        m_fpsCounter.render();
+        m_info.render();
+        m_gpuTimer.end();
+    }
+    m_gpuTimer.begin("crosshair");
+    m_crosshair.render();
+    m_gpuTimer.end();
+    if (!m_headless)
+    {
+        m_gpuTimer.begin("frame graph");
+        m_frameGraph.render();
+        m_gpuTimer.end();
+    }
 
-    glfwSwapBuffers(m_window);
+    if (m_window)
+        glfwSwapBuffers(m_window);
+    else
+        glFlush();
     Utils::glCheckError();
 }
 
 void Application::updateFrustrum()
 {
     int w, h;
-    glfwGetFramebufferSize(m_window, &w, &h);
+    getFramebufferSize(w, h);
     m_frustrum.updatePlanes(m_camera.getPosition(), m_camera.getDirection(),
                             m_camera.getUp(), m_camera.getRight(),
                             glm::radians((float)m_config.rendering().fovy), w / (float)h, 0.1f, 1000.0f);
@@ -282,6 +634,7 @@ void Application::updateProjectionMatrix(int width, int height)
 }
 
 Application::~Application() {
+    LineBatch::get().release();
     ResourceManager::textures().clear();
     ResourceManager::shaders().clear();
 }
@@ -1,26 +1,41 @@
 #ifndef APPLICATION_H_INCLUDED
 #define APPLICATION_H_INCLUDED
 
+#include <vector>
 #include <glm/mat4x4.hpp>
 
 #include "chunkmanager.h"
 #include "graphics/camera.h"
+#include "graphics/framebuffer.h"
 #include "graphics/frustrum.h"
+#include "graphics/gputimer.h"
 #include "graphics/shader.h"
 #include "graphics/skybox.h"
 #include "objects/player.h"
+#include "objects/entities.h"
 #include "ui/crosshair.h"
+#include "ui/framegraph.h"
 #include "ui/text/debuginfo.h"
 #include "ui/text/fpscounter.h"
+#include "utils/framerecorder.h"
 #include "utils/timer.h"
 
+class Benchmark;
 class Settings;
 class GLFWwindow;
 
+// how main() wants the application run, the defaults are the interactive window
+struct RunOptions
+{
+    Benchmark*          benchmark {nullptr};    // scripted flythrough without input
+    bool                headless {false};       // no window: render into an FBO, one 1/60 s step per frame
+    std::vector<float>  captures;               // run times in secs to save frames at, headless only
+};
+
 class Application
 {
 public:
-        Application(GLFWwindow* window);
+        Application(GLFWwindow* window, const RunOptions& options = {});
         ~Application();
 
     void run();
@@ -30,6 +45,7 @@ private:
     void registerCallbacks();
 
     void update(float dt = 1/60.f);
+    void updateWorld();
     void render();
     void pollEvents();
 
@@ -37,33 +53,57 @@ private:
 
     void keyCallback(int key, int action);
     void cursorPosCallback(double x, double y);
+    void mouseButtonCallback(int button, int action);
     void resizeCallback(int width, int height);
 
     void updateFrustrum();
     void updateProjectionMatrix(int width, int height);
 
     void handleKbd(float dt_sec);
+    void spawnEntities(int count);
+    void followBenchmarkPath(double time, float dt_sec = 0);
+    void captureFrames(double time);
+    double runTime() const;
+    bool shouldClose() const;
+    void getFramebufferSize(int& width, int& height) const;
 
 private:
-    GLFWwindow*             m_window;
+    GLFWwindow*             m_window;       // null when headless
+    Benchmark*              m_benchmark;    // scripted run without input if set
+    bool                    m_headless;
+    std::vector<float>      m_captures;     // sorted
+    size_t                  m_nextCapture {0};
+    glm::vec3               m_walkFrom {0}; // benchmark walker position and step of the last tick
+    float                   m_walkStep {0};
+    double                  m_runLength;    // secs, with every capture taken
+    int                     m_frameIndex {0};
+    Framebuffer             m_offscreen;
 
     Player                  m_player;
     Camera                  m_camera;
     Frustrum                m_frustrum;
     ChunkManager            m_chunkManager;
     Skybox                  m_skyBox;
+    EntityStore             m_entities;
 
     FPSCounter              m_fpsCounter;
     DebugInfo               m_info;
     Crosshair               m_crosshair;
+    FrameGraph              m_frameGraph;
+    GpuTimer                m_gpuTimer;
 
     double                  m_xprev {0},
                             m_yprev {0};
+    uint8_t                 m_placeBlock {(uint8_t)Blocks::Type::Sand};
+#ifdef DEBUG_DRAW
+    bool                    m_drawChunkBounds {false};
+#endif
 
     glm::mat4               m_proj,
                             m_view;
 
-    Timer                   m_timerMain, m_timerFpsCap;
+    Timer                   m_timerMain, m_timerFpsCap, m_runClock;
+    FrameRecorder           m_frames;
     double                  m_timeSlice {0};
 
     Settings&               m_config;
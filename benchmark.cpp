@@ -0,0 +1,174 @@
+#include "benchmark.h"
+#include "utils/framerecorder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+bool Benchmark::loadScript(const std::string& file)
+{
+    std::ifstream ifs {file};
+    if (!ifs.is_open())
+    {
+        std::cerr << "Can't open benchmark script " << file << std::endl;
+        return false;
+    }
+
+    m_file = file;
+    m_keys.clear();
+    float duration = 0;
+    std::string line;
+    for (int lineNumber = 1; std::getline(ifs, line); lineNumber++)
+    {
+        std::istringstream ss {line};
+        std::string word;
+        if (!(ss >> word) || word[0] == '#')
+            continue;
+
+        bool ok = true;
+        if (word == "seed")
+            ok = (bool)(ss >> m_seed);
+        else if (word == "duration")
+            ok = (bool)(ss >> duration);
+        else if (word == "control")
+        {
+            std::string control;
+            ss >> control;
+            if (control == "flying")
+                m_control = Flying;
+            else if (control == "walking")
+                m_control = Walking;
+            else if (control == "aabb")
+                m_control = WalkingAABB;
+            else
+                ok = false;
+        }
+        else if (word == "entities")
+        {
+            ok = (bool)(ss >> m_entityCount);
+            ss >> m_entitySecs; // optional
+        }
+        else if (word == "key")
+        {
+            Key key;
+            ok = (bool)(ss >> key.time >> key.pos.x >> key.pos.y >> key.pos.z >> key.yaw >> key.pitch);
+            if (ok)
+                m_keys.push_back(key);
+        }
+        else
+            ok = false;
+
+        if (!ok)
+            std::cerr << file << ":" << lineNumber << ": can't parse \"" << line << "\"" << std::endl;
+    }
+
+    if (m_keys.empty())
+    {
+        std::cerr << "Benchmark script " << file << " has no camera keys" << std::endl;
+        return false;
+    }
+    std::stable_sort(m_keys.begin(), m_keys.end(), [](const Key& a, const Key& b) { return a.time < b.time; });
+    m_duration = duration > 0 ? duration : m_keys.back().time;
+    return true;
+}
+
+void Benchmark::start()
+{
+    m_clock.restart();
+}
+
+double Benchmark::getElapsedSecs() const
+{
+    return m_clock.getElapsedSecs();
+}
+
+int Benchmark::entitiesToSpawn(double secs)
+{
+    if (m_entitiesSpawned || secs < m_entitySecs)
+        return 0;
+    m_entitiesSpawned = true;
+    return m_entityCount;
+}
+
+void Benchmark::addEntityStep(int entities, double ms)
+{
+    m_entitiesStepped += entities;
+    m_entityMs += ms;
+    m_entityTicks++;
+}
+
+void Benchmark::addCollisionTime(double ms)
+{
+    m_collisionUs.push_back(ms * 1000);
+}
+
+void Benchmark::addPathDistance(float blocks)
+{
+    m_pathDistances.push_back(blocks);
+}
+
+Benchmark::Key Benchmark::sample(double secs) const
+{
+    if (secs <= m_keys.front().time)
+        return m_keys.front();
+    if (secs >= m_keys.back().time)
+        return m_keys.back();
+
+    size_t i = 1;
+    while (m_keys[i].time < secs)
+        i++;
+    const Key& k1 = m_keys[i - 1];
+    const Key& k2 = m_keys[i];
+    const Key& k0 = m_keys[i > 1 ? i - 2 : i - 1];
+    const Key& k3 = m_keys[std::min(i + 1, m_keys.size() - 1)];
+
+    float t = k2.time > k1.time ? (secs - k1.time) / (k2.time - k1.time) : 1;
+    float t2 = t * t, t3 = t2 * t;
+
+    Key key;
+    key.time = secs;
+    key.pos = 0.5f * ((2.0f * k1.pos) + (k2.pos - k0.pos) * t +
+                      (2.0f * k0.pos - 5.0f * k1.pos + 4.0f * k2.pos - k3.pos) * t2 +
+                      (3.0f * k1.pos - k0.pos - 3.0f * k2.pos + k3.pos) * t3);
+    key.yaw = k1.yaw + (k2.yaw - k1.yaw) * t;
+    key.pitch = k1.pitch + (k2.pitch - k1.pitch) * t;
+    return key;
+}
+
+void Benchmark::report(std::ostream& out, const FrameRecorder& frames,
+                       const std::vector<float>& loadLatenciesMs, size_t peakMemoryBytes) const
+{
+    auto line = [&out](const char* name, const FrameRecorder::Summary& s)
+    {
+        out << name << " p50 " << s.p50 << ", p95 " << s.p95 << ", p99 " << s.p99 << ", max " << s.max << '\n';
+    };
+
+    double elapsed = getElapsedSecs();
+    auto precision = out.precision();
+    out << std::fixed << std::setprecision(2);
+    const char* controls[] = {"flying", "walking", "walking, voxel AABB collisions"};
+    out << "benchmark " << m_file << ", seed " << m_seed << ", " << controls[m_control] << ", " << elapsed << " s\n";
+    out << "frames " << frames.getLoggedCount() << ", average fps " << frames.getLoggedCount() / elapsed << '\n';
+    line("frame ms", frames.getRunFrameSummary());
+    line("cpu ms", frames.getRunCpuSummary());
+    out << "hitches > " << frames.getHitchThreshold() << " ms: " << frames.getHitchCount() << '\n';
+    out << "column loads " << loadLatenciesMs.size() << '\n';
+    line("load latency ms", FrameRecorder::summarize(loadLatenciesMs));
+    if (m_control != Flying)
+    {
+        double total = 0;
+        for (float us : m_collisionUs)
+            total += us;
+        out << "collision ticks " << m_collisionUs.size() << ", total ms " << total / 1000 << '\n';
+        line("collision us", FrameRecorder::summarize(m_collisionUs));
+        line("behind path blocks", FrameRecorder::summarize(m_pathDistances));
+    }
+    if (m_entityCount > 0)
+        out << "entities " << m_entityCount << " spawned at " << m_entitySecs << " s, "
+            << (m_entityMs > 0 ? m_entitiesStepped / m_entityMs : 0) << " entities/ms over "
+            << m_entityTicks << " ticks, " << m_entityMs << " ms total\n";
+    out << "peak memory MB " << peakMemoryBytes / (1024.0 * 1024.0) << '\n';
+    out << std::defaultfloat << std::setprecision(precision);
+}
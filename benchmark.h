@@ -0,0 +1,81 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <glm/vec3.hpp>
+
+#include "utils/timer.h"
+
+class FrameRecorder;
+
+/*
+    Scripted flythrough for comparing builds: a fixed world seed and a camera
+    path through key poses, run for a fixed time without input. The script is
+    a text file of lines
+
+        seed <n>
+        duration <secs>                     (defaults to the last key)
+        control flying|walking|aabb         (defaults to flying)
+        entities <n> [<secs>]               falling blocks dropped around the player
+        key <secs> <x> <y> <z> <yaw> <pitch>
+
+    Positions follow a Catmull-Rom spline through the keys, angles are
+    interpolated linearly. The flying camera is placed on the path; walking
+    controls (ellipsoid or voxel AABB collisions) are steered along it in the
+    horizontal plane at walking speed and left to collide with the terrain,
+    looking where they go. They fall behind where the path is faster than that,
+    the report tells by how much.
+*/
+class Benchmark
+{
+public:
+    enum Control {Flying, Walking, WalkingAABB};
+
+    struct Key
+    {
+        float       time;
+        glm::vec3   pos;
+        float       yaw, pitch;
+    };
+
+    bool loadScript(const std::string& file);  // complains to cerr and returns false
+
+    int getSeed() const             {return m_seed;}
+    float getDuration() const       {return m_duration;}
+    Control getControl() const      {return m_control;}
+
+    // wall clock for the report; the path itself is sampled at the caller's run time
+    void start();
+    double getElapsedSecs() const;
+    Key sample(double secs) const;
+
+    // the entity count once the run reaches the spawn time, 0 before and after
+    int entitiesToSpawn(double secs);
+
+    // per physics tick, for the report
+    void addCollisionTime(double ms);
+    void addPathDistance(float blocks); // how far a walker is behind the path
+    void addEntityStep(int entities, double ms);
+
+    void report(std::ostream& out, const FrameRecorder& frames,
+                const std::vector<float>& loadLatenciesMs, size_t peakMemoryBytes) const;
+
+private:
+    std::string         m_file;
+    int                 m_seed {1};
+    float               m_duration {0};
+    Control             m_control {Flying};
+    int                 m_entityCount {0};
+    float               m_entitySecs {0};
+    bool                m_entitiesSpawned {false};
+    std::vector<Key>    m_keys;
+    Timer               m_clock;
+    std::vector<float>  m_collisionUs;     // per tick, too short for ms at report precision
+    std::vector<float>  m_pathDistances;   // per tick, blocks
+    double              m_entitiesStepped {0}, m_entityMs {0};
+    int                 m_entityTicks {0};
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,33 @@
+#ifndef BLOCKREGION_H
+#define BLOCKREGION_H
+
+#include <cstdint>
+#include <vector>
+#include "utils/position3.h"
+
+// Dense copy of a box of world blocks, filled by ChunkManager::getRegion.
+// Layout matches Chunk: x-major, z is the fastest changing index.
+struct BlockRegion
+{
+    Position3               origin; // world position of the min corner
+    Position3               size;
+    std::vector<uint8_t>    blocks;
+
+    bool contains(int x, int y, int z) const
+    {
+        return x >= origin.x && x < origin.x + size.x &&
+               y >= origin.y && y < origin.y + size.y &&
+               z >= origin.z && z < origin.z + size.z;
+    }
+    int index(int x, int y, int z) const
+    {
+        return ((x - origin.x) * size.y + (y - origin.y)) * size.z + (z - origin.z);
+    }
+    // world coordinates, blocks outside of the region read as empty
+    uint8_t get(int x, int y, int z) const
+    {
+        return contains(x, y, z) ? blocks[index(x, y, z)] : (uint8_t)0;
+    }
+};
+
+#endif // BLOCKREGION_H
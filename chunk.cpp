@@ -2,54 +2,128 @@
 #include "chunkmanager.h"
 #include "glad/glad.h"
 #include <glm/glm.hpp>
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <vector>
 
+#include "settings.h"
+#include "graphics/glstate.h"
 #include "utils/utils.h"
 #include "utils/drawcalltrack.h"
+#include "utils/profiler.h"
 
 using byte4 = glm::tvec4<GLbyte>;
+using ubyte4 = glm::tvec4<GLubyte>;
 
 using namespace Blocks;
 
+struct Chunk::Padded
+{
+    uint8_t blocks[CX + 2][CY + 2][CZ + 2];
+    uint8_t light[CX + 2][CY + 2][CZ + 2];
+};
+
+// light of cells whose chunk isn't loaded or lit yet: open sky
+constexpr uint8_t DefaultLight = 0xf0;
+
+enum Face {NegX = 0, PosX, NegY, PosY, NegZ, PosZ};
+
+constexpr int FaceNormals[6][3] = {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+};
+
+// face corners, triangles are (0, 1, 2) and (2, 1, 3)
+constexpr int FaceCorners[6][4][3] = {
+    {{0, 0, 0}, {0, 0, 1}, {0, 1, 0}, {0, 1, 1}},
+    {{1, 0, 0}, {1, 1, 0}, {1, 0, 1}, {1, 1, 1}},
+    {{0, 0, 0}, {1, 0, 0}, {0, 0, 1}, {1, 0, 1}},
+    {{0, 1, 1}, {1, 1, 1}, {0, 1, 0}, {1, 1, 0}},
+    {{0, 1, 0}, {1, 1, 0}, {0, 0, 0}, {1, 0, 0}},
+    {{1, 0, 1}, {1, 1, 1}, {0, 0, 1}, {0, 1, 1}},
+};
+
 static inline bool isTransparent(uint8_t block)
 {
-    return block == static_cast<uint8_t>(Blocks::Type::None) ||
-           block == static_cast<uint8_t>(Blocks::Type::Water) ||
-           block == static_cast<uint8_t>(Blocks::Type::Glass);
+    return !Blocks::isOpaque(block);
+}
+
+static void setupVertexArray(unsigned int vao, unsigned int vbo)
+{
+    GLState::bindVertexArray(vao);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 4, GL_BYTE, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, pos));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, light));
+    glEnableVertexAttribArray(1);
 }
-static inline bool isWater(uint8_t block)
+
+// Occlusion of a face corner, 0 (darkest) .. 3, from the three blocks around the corner
+// in the layer in front of the face. (ax, ay, az) is the padded cell in front of the face.
+static inline uint8_t cornerOcclusion(const uint8_t (&blocks)[CX + 2][CY + 2][CZ + 2],
+                                      int ax, int ay, int az, int face, const int* corner)
 {
-    return block == static_cast<uint8_t>(Blocks::Type::Water);
+    int axis = face / 2;
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    int side1[3] = {ax, ay, az}, side2[3] = {ax, ay, az}, diagonal[3] = {ax, ay, az};
+    side1[u] += corner[u] * 2 - 1;
+    side2[v] += corner[v] * 2 - 1;
+    diagonal[u] += corner[u] * 2 - 1;
+    diagonal[v] += corner[v] * 2 - 1;
+
+    bool s1 = isOpaque(blocks[side1[0]][side1[1]][side1[2]]);
+    bool s2 = isOpaque(blocks[side2[0]][side2[1]][side2[2]]);
+    bool d = isOpaque(blocks[diagonal[0]][diagonal[1]][diagonal[2]]);
+    if (s1 && s2)
+        return 0;
+    return 3 - (s1 + s2 + d);
 }
 
 Chunk::Chunk(ChunkManager* manager, Position3 index)
     : m_parent(manager), m_pos(index)
 {
     memset(m_blocks, 0, sizeof m_blocks);
-    glGenVertexArrays(1, &m_vao);
-    glBindVertexArray(m_vao);
-    glGenBuffers(1, &m_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glVertexAttribPointer(0, 4, GL_BYTE, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
+    memset(m_light, 0, sizeof m_light);
 }
 
 Chunk::~Chunk()
 {
-    glDeleteBuffers(1, &m_vbo);
-    glDeleteVertexArrays(1, &m_vao);
+    if (!m_vao)
+        return;
+    GLState::deleteBuffer(m_vbo);
+    GLState::deleteVertexArray(m_vao);
+    GLState::deleteBuffer(m_translucentVbo);
+    GLState::deleteVertexArray(m_translucentVao);
+}
+
+void Chunk::createGLObjects()
+{
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    setupVertexArray(m_vao, m_vbo);
+    glGenVertexArrays(1, &m_translucentVao);
+    glGenBuffers(1, &m_translucentVbo);
+    setupVertexArray(m_translucentVao, m_translucentVbo);
 }
 
-bool Chunk::empty()
+bool Chunk::empty() const
 {
     return m_empty;
 }
 
-bool Chunk::changed()
+bool Chunk::changed() const
 {
     return m_changed;
 }
 
+// a neighbour's blocks changed, so faces on the border may show up even if the last mesh was empty
+void Chunk::setChanged()
+{
+    m_changed = true;
+    m_empty = false;
+}
+
 Blocks::Type Chunk::get(const Position3 &pos) const
 {
     assert(pos.x < CX && pos.y < CY && pos.z < CZ);
@@ -62,13 +136,43 @@ uint8_t Chunk::getRaw(const Position3 &pos) const
     return m_blocks[pos.x][pos.y][pos.z];
 }
 
+const uint8_t* Chunk::getRawRow(int x, int y) const
+{
+    assert(x < CX && y < CY);
+    return m_blocks[x][y];
+}
+
+const uint8_t* Chunk::getRawBlocks() const
+{
+    return &m_blocks[0][0][0];
+}
+
+void Chunk::setLight(const uint8_t* light)
+{
+    memcpy(m_light, light, sizeof m_light);
+    m_lit = true;
+    // light alone doesn't add faces to a chunk without any
+    if (!m_empty)
+        m_changed = true;
+}
+
+uint8_t Chunk::getRawLight(const Position3 &pos) const
+{
+    assert(pos.x < CX && pos.y < CY && pos.z < CZ);
+    return m_light[pos.x][pos.y][pos.z];
+}
+
+bool Chunk::lit() const
+{
+    return m_lit;
+}
+
 void Chunk::set(const Position3 &pos, Blocks::Type type)
 {
     assert(pos.x < CX && pos.y < CY && pos.z < CZ);
     m_blocks[pos.x][pos.y][pos.z] = static_cast<uint8_t>(type);
     m_changed = true;
-    if (type != Blocks::Type::None)
-        m_empty = false;
+    m_empty = false; // removing a block from a closed chunk uncovers faces too
 }
 
 void Chunk::setRaw(const Position3& pos, uint8_t type)
@@ -76,93 +180,140 @@ void Chunk::setRaw(const Position3& pos, uint8_t type)
     assert(pos.x < CX && pos.y < CY && pos.z < CZ);
     m_blocks[pos.x][pos.y][pos.z] = type;
     m_changed = true;
-    if (type)
-        m_empty = false;
+    m_empty = false;
 }
 
-void Chunk::updateVBO()
+void Chunk::gatherPadded(Padded& padded) const
 {
-    byte4 vertices[CX * CY * CZ * 6 * 6];
-    int i = 0;
+    // along each axis a neighbour contributes its last layer (-1), all of it (0) or its first layer (+1)
+    auto range = [](int d, int size, int& src, int& dst, int& count)
+    {
+        src = d < 0 ? size - 1 : 0;
+        dst = d < 0 ? 0 : d == 0 ? 1 : size + 1;
+        count = d == 0 ? size : 1;
+    };
+
+    for (int dx = -1; dx <= 1; dx++)
+    for (int dy = -1; dy <= 1; dy++)
+    for (int dz = -1; dz <= 1; dz++)
+    {
+        const Chunk* n = (dx == 0 && dy == 0 && dz == 0) ? this
+                       : m_parent->getChunk({m_pos.x + dx, m_pos.y + dy, m_pos.z + dz});
+        int sx, sy, sz, tx, ty, tz, nx, ny, nz;
+        range(dx, CX, sx, tx, nx);
+        range(dy, CY, sy, ty, ny);
+        range(dz, CZ, sz, tz, nz);
+
+        for (int x = 0; x < nx; x++)
+        for (int y = 0; y < ny; y++)
+        {
+            uint8_t* blocks = &padded.blocks[tx + x][ty + y][tz];
+            uint8_t* light = &padded.light[tx + x][ty + y][tz];
+            if (n)
+                memcpy(blocks, &n->m_blocks[sx + x][sy + y][sz], nz);
+            else
+                memset(blocks, 0, nz);
+            if (n && n->m_lit)
+                memcpy(light, &n->m_light[sx + x][sy + y][sz], nz);
+            else
+                memset(light, DefaultLight, nz);
+        }
+    }
+}
+
+void Chunk::buildMesh(std::vector<ChunkVertex>& opaque, std::vector<ChunkVertex>& translucent) const
+{
+    static thread_local Padded padded;
+
+    gatherPadded(padded);
+    opaque.clear();
+    translucent.clear();
+    const bool ambientOcclusion = Settings::get().rendering().ambientOcclusion;
 
     for (auto x = 0; x < CX; x++)
     for (auto y = 0; y < CY; y++)
     for (auto z = 0; z < CZ; z++)
     {
-        uint8_t type = m_blocks[x][y][z];
+        uint8_t type = padded.blocks[x + 1][y + 1][z + 1];
 
         if (type == static_cast<uint8_t>(Blocks::Type::None))
             continue;
-        // View from negative x
-        if (shouldDrawFace({x, y, z}, Face::NegX))
-        {
-            vertices[i++] = byte4(x,     y,     z,     type);
-            vertices[i++] = byte4(x,     y,     z + 1, type);
-            vertices[i++] = byte4(x,     y + 1, z,     type);
-            vertices[i++] = byte4(x,     y + 1, z,     type);
-            vertices[i++] = byte4(x,     y,     z + 1, type);
-            vertices[i++] = byte4(x,     y + 1, z + 1, type);
-        }
-        // View from positive x
-        if (shouldDrawFace({x, y, z}, Face::PosX))
-        {
-            vertices[i++] = byte4(x + 1, y,     z,     type);
-            vertices[i++] = byte4(x + 1, y + 1, z,     type);
-            vertices[i++] = byte4(x + 1, y,     z + 1, type);
-            vertices[i++] = byte4(x + 1, y + 1, z,     type);
-            vertices[i++] = byte4(x + 1, y + 1, z + 1, type);
-            vertices[i++] = byte4(x + 1, y,     z + 1, type);
-        }
-        // View from negative y
-        if (shouldDrawFace({x, y, z}, Face::NegY))
-        {
-            vertices[i++] = byte4(x,     y,     z,     -type);  // negative values are used in fragment shader to obtain texture coords
-            vertices[i++] = byte4(x + 1, y,     z,     -type);  // for +y and -y faces, positive for 4 others
-            vertices[i++] = byte4(x,     y,     z + 1, -type);
-            vertices[i++] = byte4(x,     y,     z + 1, -type);
-            vertices[i++] = byte4(x + 1, y,     z,     -type);
-            vertices[i++] = byte4(x + 1, y,     z + 1, -type);
-        }
-        // View from positive y
-        if (shouldDrawFace({x, y, z}, Face::PosY))
-        {
-            vertices[i++] = byte4(x,     y + 1, z,     -type);
-            vertices[i++] = byte4(x,     y + 1, z + 1, -type);
-            vertices[i++] = byte4(x + 1, y + 1, z + 1, -type);
-            vertices[i++] = byte4(x + 1, y + 1, z + 1, -type);
-            vertices[i++] = byte4(x + 1, y + 1, z,     -type);
-            vertices[i++] = byte4(x,     y + 1, z,     -type);
-        }
-        // View from negative z
-        if (shouldDrawFace({x, y, z}, Face::NegZ))
-        {
-            vertices[i++] = byte4(x,     y,     z,     type);
-            vertices[i++] = byte4(x,     y + 1, z,     type);
-            vertices[i++] = byte4(x + 1, y + 1, z,     type);
-            vertices[i++] = byte4(x + 1, y + 1, z,     type);
-            vertices[i++] = byte4(x + 1, y,     z,     type);
-            vertices[i++] = byte4(x,     y,     z,     type);
-        }
-        // View from positive z
-        if (shouldDrawFace({x, y, z}, Face::PosZ))
+
+        for (int f = 0; f < 6; f++)
         {
-            vertices[i++] = byte4(x,     y,     z + 1, type);
-            vertices[i++] = byte4(x + 1, y,     z + 1, type);
-            vertices[i++] = byte4(x + 1, y + 1, z + 1, type);
-            vertices[i++] = byte4(x + 1, y + 1, z + 1, type);
-            vertices[i++] = byte4(x,     y + 1, z + 1, type);
-            vertices[i++] = byte4(x,     y,     z + 1, type);
+            const int* n = FaceNormals[f];
+            int ax = x + 1 + n[0], ay = y + 1 + n[1], az = z + 1 + n[2];
+            uint8_t neighbour = padded.blocks[ax][ay][az];
+
+            if (!isTransparent(neighbour))
+                continue;
+            // no faces between two blocks of the same see-through kind (water, glass)
+            if (neighbour == type)
+                continue;
+            std::vector<ChunkVertex>& out = isTransparent(type) ? translucent : opaque;
+
+            // negative w is used in fragment shader to obtain texture coords
+            // for +y and -y faces, positive for 4 others
+            GLbyte w = (f == NegY || f == PosY) ? -type : type;
+
+            // a face is lit by the cell in front of it
+            uint8_t light = padded.light[ax][ay][az];
+            ubyte4 faceLight(light >> 4, light & 0xf, 0, 0);
+
+            ChunkVertex corners[4];
+            for (int c = 0; c < 4; c++)
+            {
+                const int* corner = FaceCorners[f][c];
+                corners[c] = {byte4(x + corner[0], y + corner[1], z + corner[2], w), faceLight};
+                corners[c].light.z = ambientOcclusion ? cornerOcclusion(padded.blocks, ax, ay, az, f, corner) : 3;
+            }
+            // split the quad along its darker diagonal, otherwise the occlusion
+            // gradient depends on which way the triangles happen to run
+            if (corners[1].light.z + corners[2].light.z > corners[0].light.z + corners[3].light.z)
+            {
+                out.push_back(corners[0]);
+                out.push_back(corners[1]);
+                out.push_back(corners[3]);
+                out.push_back(corners[0]);
+                out.push_back(corners[3]);
+                out.push_back(corners[2]);
+            }
+            else
+            {
+                out.push_back(corners[0]);
+                out.push_back(corners[1]);
+                out.push_back(corners[2]);
+                out.push_back(corners[2]);
+                out.push_back(corners[1]);
+                out.push_back(corners[3]);
+            }
         }
     }
-    m_elements = i;
+}
+
+void Chunk::updateVBO()
+{
+    PROFILE_ZONE("Chunk::updateVBO");
+    static thread_local std::vector<ChunkVertex> vertices;
+
+    buildMesh(vertices, m_translucent);
+    if (!m_vao && (!vertices.empty() || !m_translucent.empty()))
+        createGLObjects();
+
+    m_elements = vertices.size();
     if (m_elements > 0)
     {
-        m_empty = false;
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        glBufferData(GL_ARRAY_BUFFER, m_elements * sizeof *vertices, vertices, GL_STATIC_DRAW);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glBufferData(GL_ARRAY_BUFFER, m_elements * sizeof(ChunkVertex), vertices.data(), GL_STATIC_DRAW);
     }
-    else
-        m_empty = true;
+    if (!m_translucent.empty())
+    {
+        // storage only, sortTranslucent fills it
+        GLState::bindBuffer(GL_ARRAY_BUFFER, m_translucentVbo);
+        glBufferData(GL_ARRAY_BUFFER, m_translucent.size() * sizeof(ChunkVertex), nullptr, GL_DYNAMIC_DRAW);
+    }
+    m_empty = m_elements == 0 && m_translucent.empty();
+    m_sorted = false;
     m_changed = false;
 }
 
@@ -171,102 +322,65 @@ void Chunk::render()
     if(!m_elements)
         return;
 
-    glBindVertexArray(m_vao);
+    GLState::bindVertexArray(m_vao);
     glDrawArrays_(GL_TRIANGLES, 0, m_elements);
 }
 
-const Position3& Chunk::getIndex() const
+void Chunk::renderTranslucent()
 {
-    return m_pos;
+    if (m_translucent.empty() || !m_sorted)
+        return;
+
+    GLState::bindVertexArray(m_translucentVao);
+    glDrawArrays_(GL_TRIANGLES, 0, m_translucent.size());
 }
 
-bool Chunk::shouldDrawFace(Position3 p, Face face)
+bool Chunk::hasTranslucent() const
 {
-    auto neighbour = getAdjacentBlock(p, face);
-    auto current = m_blocks[p.x][p.y][p.z];
-
-    if (isWater(current) && isWater(neighbour))
-        return false;
-    if (isTransparent(neighbour))
-        return true;
-    return false;
+    return !m_translucent.empty();
 }
 
-uint8_t Chunk::getAdjacentBlock(Position3 p, Face face)
+void Chunk::sortTranslucent(const Position3& cameraChunk, const glm::vec3& localEye)
 {
-    auto block = static_cast<uint8_t>(Type::None);
-    Chunk* n = nullptr;
+    if (m_translucent.empty() || (m_sorted && m_sortedFor == cameraChunk))
+        return;
+
+    static thread_local std::vector<std::pair<float, int>> order;
+    static thread_local std::vector<ChunkVertex> sorted;
 
-    switch (face)
+    int faces = m_translucent.size() / 6;
+    order.clear();
+    for (int f = 0; f < faces; f++)
     {
-    case Face::NegX:
-        if (p.x == 0)
+        // face center is the middle of the bounding box of its 6 vertices
+        const ChunkVertex* v = &m_translucent[f * 6];
+        glm::vec3 min(v[0].pos.x, v[0].pos.y, v[0].pos.z), max = min;
+        for (int i = 1; i < 6; i++)
         {
-            n = m_parent->getChunk({m_pos.x - 1, m_pos.y, m_pos.z});
-            if (n)
-                block = n->getRaw({CX - 1, p.y, p.z});
+            glm::vec3 p(v[i].pos.x, v[i].pos.y, v[i].pos.z);
+            min = glm::min(min, p);
+            max = glm::max(max, p);
         }
-        else
-            block = m_blocks[p.x - 1][p.y][p.z];
-        break;
+        glm::vec3 d = (min + max) * 0.5f - localEye;
+        order.emplace_back(glm::dot(d, d), f);
+    }
+    std::sort(order.begin(), order.end(), [](const std::pair<float, int>& a, const std::pair<float, int>& b)
+    {
+        return a.first > b.first;
+    });
 
-    case Face::PosX:
-        if (p.x == CX - 1)
-        {
-            n = m_parent->getChunk({m_pos.x + 1, m_pos.y, m_pos.z});
-            if (n)
-                block = n->getRaw({0, p.y, p.z});
-        }
-        else
-            block = m_blocks[p.x + 1][p.y][p.z];
-        break;
+    sorted.resize(m_translucent.size());
+    for (int f = 0; f < faces; f++)
+        std::copy_n(&m_translucent[order[f].second * 6], 6, &sorted[f * 6]);
 
-    case Face::NegY:
-        if (p.y == 0)
-        {
-            n = m_parent->getChunk({m_pos.x, m_pos.y - 1, m_pos.z});
-            if (n)
-                block = n->getRaw({p.x, CY - 1, p.z});
-        }
-        else
-            block = m_blocks[p.x][p.y - 1][p.z];
-        break;
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_translucentVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sorted.size() * sizeof(ChunkVertex), sorted.data());
 
-    case Face::PosY:
-        if (p.y == CY - 1)
-        {
-            n = m_parent->getChunk({m_pos.x, m_pos.y + 1, m_pos.z});
-            if (n)
-                block = n->getRaw({p.x, 0, p.z});
-        }
-        else
-            block = m_blocks[p.x][p.y + 1][p.z];
-        break;
-
-    case Face::NegZ:
-        if (p.z == 0)
-        {
-            n = m_parent->getChunk({m_pos.x, m_pos.y, m_pos.z - 1});
-            if (n)
-                block = n->getRaw({p.x, p.y, CZ - 1});
-        }
-        else
-            block = m_blocks[p.x][p.y][p.z - 1];
-        break;
-
-    case Face::PosZ:
-        if (p.z == CZ - 1)
-        {
-            n = m_parent->getChunk({m_pos.x, m_pos.y, m_pos.z + 1});
-            if (n)
-                block = n->getRaw({p.x, p.y, 0});
-        }
-        else
-            block = m_blocks[p.x][p.y][p.z + 1];
-        break;
+    m_sorted = true;
+    m_sortedFor = cameraChunk;
+}
 
-    default:
-        break;
-    }
-    return block;
+const Position3& Chunk::getIndex() const
+{
+    return m_pos;
 }
@@ -2,13 +2,19 @@
 #define CHUNK_H_INCLUDED
 
 #include <cstdint>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include "graphics/renderable.h"
 #include "utils/constants.h"
 #include "utils/position3.h"
 
 namespace Blocks
 {
-constexpr int CX = 16, CY = 16, CZ = 16;
+// chunk dimensions are powers of two, so world -> chunk/local conversion is a shift and a mask
+constexpr int CX_SHIFT = 4, CY_SHIFT = 4, CZ_SHIFT = 4;
+constexpr int CX = 1 << CX_SHIFT, CY = 1 << CY_SHIFT, CZ = 1 << CZ_SHIFT;
+constexpr int CX_MASK = CX - 1, CY_MASK = CY - 1, CZ_MASK = CZ - 1;
 enum class Type
 {
     None = 0,
@@ -18,12 +24,40 @@ enum class Type
     Stone,
     Snow,
     Sand,
-    Water
+    Water,
+    Lamp
 };
+
+// blocks that stop the player and rays
+inline bool isSolid(uint8_t block)
+{
+    return block != static_cast<uint8_t>(Type::None) &&
+           block != static_cast<uint8_t>(Type::Water);
+}
+
+// blocks that stop light
+inline bool isOpaque(uint8_t block)
+{
+    return block != static_cast<uint8_t>(Type::None) &&
+           block != static_cast<uint8_t>(Type::Water) &&
+           block != static_cast<uint8_t>(Type::Glass);
+}
+
+// block light level emitted, 0..15
+inline uint8_t lightEmission(uint8_t block)
+{
+    return block == static_cast<uint8_t>(Type::Lamp) ? 14 : 0;
+}
 }
 
 class ChunkManager;
 
+struct ChunkVertex
+{
+    glm::tvec4<int8_t>  pos;    // w is the block type
+    glm::tvec4<uint8_t> light;  // sky light, block light, ambient occlusion
+};
+
 class Chunk : Renderable
 {
 public:
@@ -32,30 +66,55 @@ public:
 
     Blocks::Type    get(const Position3 &pos) const;
     uint8_t         getRaw(const Position3 &pos) const;
+    const uint8_t*  getRawRow(int x, int y) const; // CZ blocks along z
+    const uint8_t*  getRawBlocks() const; // all blocks, x-major, z fastest
 
     void            set(const Position3 &pos, Blocks::Type type);
     void            setRaw(const Position3 &pos, uint8_t type);
 
-    void            updateVBO();
-    void            render();
+    // faces of the chunk against its neighbours, CPU only; translucent faces are
+    // 6 vertices each in the order sortTranslucent expects
+    void            buildMesh(std::vector<ChunkVertex>& opaque, std::vector<ChunkVertex>& translucent) const;
+    void            updateVBO();            // buildMesh and upload
+    void            render();               // opaque faces
+    void            renderTranslucent();    // water and glass
+
+    bool            hasTranslucent() const;
+    // orders translucent faces back to front as seen from localEye (relative to the chunk
+    // origin), but only if the camera has moved into another chunk since the last sort
+    void            sortTranslucent(const Position3& cameraChunk, const glm::vec3& localEye);
 
     const Position3& getIndex() const;
 
-    bool            empty();
-    bool            changed();
+    bool            empty() const;
+    bool            changed() const;
+    void            setChanged();
+
+    // sky light in the high nibble, block light in the low one, same layout as the blocks
+    void            setLight(const uint8_t* light);
+    uint8_t         getRawLight(const Position3 &pos) const;
+    bool            lit() const; // light has been computed at least once
 
 private:
-    enum class Face {NegX = 0, PosX, NegY, PosY, NegZ, PosZ};
+    struct Padded;
 
-    bool            shouldDrawFace(Position3 p, Face face);
-    uint8_t         getAdjacentBlock(Position3 p, Face face);
+    // copies blocks and light of the chunk and a one block border around it
+    void            gatherPadded(Padded& padded) const;
+    void            createGLObjects();
 
 private:
     bool            m_changed {false};
     bool            m_empty {true};
+    bool            m_lit {false};
     uint8_t         m_blocks[Blocks::CX][Blocks::CY][Blocks::CZ];
-    unsigned int    m_vao, m_vbo;
+    uint8_t         m_light[Blocks::CX][Blocks::CY][Blocks::CZ];
+    // created on the first upload, so that chunks can be built and meshed without GL
+    unsigned int    m_vao {0}, m_vbo {0};
     int             m_elements {0};
+    unsigned int    m_translucentVao {0}, m_translucentVbo {0};
+    std::vector<ChunkVertex> m_translucent; // kept for sorting, 6 vertices per face
+    bool            m_sorted {false};
+    Position3       m_sortedFor;            // camera chunk of the last sort
     ChunkManager*   m_parent;
     Position3       m_pos;
 };
@@ -4,14 +4,20 @@
 //#include <iostream>
 #include <algorithm>
 #include <cstring>
+#include <cmath>
+#include <limits>
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "graphics/frustrum.h"
+#include "graphics/glstate.h"
 #include "settings.h"
 #include "terrain/heightmapprovider.h"
 #include "utils/utils.h"
+#include "utils/profiler.h"
 
+// loads may take only this share of the streaming budget, the rest is kept for meshing
+constexpr double loadBudgetShare = 0.5;
 
 ChunkManager::ChunkManager(Frustrum& frustrum)
     : m_frustrum(frustrum)
@@ -24,16 +30,52 @@ ChunkManager::ChunkManager(Frustrum& frustrum)
         m_config.world().maxChunkColsLoaded = minChunkColsLoaded;
     m_renderList.reserve(minChunkColsLoaded);
     m_chunkColumns.reserve(m_config.world().maxChunkColsLoaded);
+    m_budget.setLimits(m_config.world().streamBudgetMinMs / 1000.0,
+                       m_config.world().streamBudgetMaxMs / 1000.0);
+    m_lighting.start(m_config.world().chunksInCol);
+}
+
+FrameBudget& ChunkManager::streamingBudget()
+{
+    return m_budget;
+}
+
+void ChunkManager::setDeterministic(bool deterministic)
+{
+    m_deterministic = deterministic;
+    m_budget.setUnlimited(deterministic);
 }
 
 void ChunkManager::setTransform(const glm::mat4& transform)
 {
     m_shader->use();
     m_shader->setMat4("proj_view", &transform[0][0]);
+    m_translucentShader->use();
+    m_translucentShader->setMat4("proj_view", &transform[0][0]);
+}
+
+void ChunkManager::setCameraPosition(const glm::vec3& position)
+{
+    m_cameraPosition = position;
+}
+
+void ChunkManager::setAnimationTime(double secs)
+{
+    m_animationTime = secs;
+}
+
+void ChunkManager::setTranslucentShader(Shader& shader)
+{
+    m_translucentShader = &shader;
 }
 
 void ChunkManager::update(const Position3 &playerPosition)
 {
+    PROFILE_ZONE("ChunkManager::update");
+    if (m_deterministic)
+        m_lighting.wait();
+    applyLight();
+
     // if position is same and nothing to load, let's re-update chunks to remove extra vertices between chunks
     if (playerPosition.x == m_oldPlayerPos.x &&
         playerPosition.z == m_oldPlayerPos.z &&
@@ -51,8 +93,8 @@ void ChunkManager::update(const Position3 &playerPosition)
     // get positions for chunk column _potential_ rendering
     std::vector<Position3> renderPositions;
     for (const auto& i : m_lookupIndexBuffer)
-        renderPositions.emplace_back(playerPosition.x / Blocks::CX + i.first, 0,
-                                     playerPosition.z / Blocks::CZ + i.second);
+        renderPositions.emplace_back((playerPosition.x >> Blocks::CX_SHIFT) + i.first, 0,
+                                     (playerPosition.z >> Blocks::CZ_SHIFT) + i.second);
     // fill render list (find in map or load if not present)
     m_chunkColsLoaded = 0;
 
@@ -63,9 +105,13 @@ void ChunkManager::update(const Position3 &playerPosition)
             m_renderList.emplace_back(&it->second);
         else
         {
-            if (m_chunkColsLoaded == m_config.world().maxLoadsPerFrame)
+            // always load at least one column per call so streaming never stalls
+            if (m_chunkColsLoaded > 0 && !m_budget.hasTime(loadBudgetShare))
                 continue;
 
+            m_budget.startTask();
+            m_pendingLoads[pos] = m_timer.getElapsedSecs();
+
             ChunkColumn newColumn;
             newColumn.reserve(m_config.world().chunksInCol);
 
@@ -75,24 +121,28 @@ void ChunkManager::update(const Position3 &playerPosition)
 
             // Queue an Update of 4 adjacent chunks in XZ plane if they exist already for all chunks in created column
             if (getChunk(Position3 {pos.x - 1, 0, pos.z}))
-                m_adjacentUpdateQueue.emplace(Position3 {pos.x - 1, 0, pos.z});
+                m_adjacentUpdateQueue.emplace_back(Position3 {pos.x - 1, 0, pos.z});
             if (getChunk(Position3 {pos.x + 1, 0, pos.z}))
-                m_adjacentUpdateQueue.emplace(Position3 {pos.x + 1, 0, pos.z});
+                m_adjacentUpdateQueue.emplace_back(Position3 {pos.x + 1, 0, pos.z});
             if (getChunk(Position3 {pos.x, 0, pos.z - 1}))
-                m_adjacentUpdateQueue.emplace(Position3 {pos.x, 0, pos.z - 1});
+                m_adjacentUpdateQueue.emplace_back(Position3 {pos.x, 0, pos.z - 1});
             if (getChunk(Position3 {pos.x, 0, pos.z + 1}))
-                m_adjacentUpdateQueue.emplace(Position3 {pos.x, 0, pos.z + 1});
+                m_adjacentUpdateQueue.emplace_back(Position3 {pos.x, 0, pos.z + 1});
 
             HeightMapProvider::fillChunkColumn(newColumn);
 
             auto ins = m_chunkColumns.emplace(pos, std::move(newColumn));
             assert(ins.second);
 
+            logColumnChange(pos);
+            m_lighting.loadColumn(pos, ins.first->second);
+
             auto colPtr = &ins.first->second;
             m_renderList.emplace_back(colPtr);
             m_loadedQueue.emplace(colPtr);
 
             m_chunkColsLoaded++;
+            m_budget.finishTask();
         }
     }
 
@@ -106,21 +156,120 @@ void ChunkManager::update(const Position3 &playerPosition)
     updateAdjacent();
 }
 
+void ChunkManager::generateRegion(const Position3& min, const Position3& max, void (*fill)(ChunkColumn&))
+{
+    for (int x = min.x; x <= max.x; x++)
+    for (int z = min.z; z <= max.z; z++)
+    {
+        Position3 pos {x, 0, z};
+        if (getColumn(pos))
+            continue;
+
+        ChunkColumn column;
+        column.reserve(m_config.world().chunksInCol);
+        for (auto y = 0; y < m_config.world().chunksInCol; y++)
+            column.emplace_back(this, Position3 {x, y, z});
+        fill(column);
+
+        auto ins = m_chunkColumns.emplace(pos, std::move(column));
+        logColumnChange(pos);
+        m_loadedQueue.emplace(&ins.first->second);
+    }
+}
+
+void ChunkManager::simulate(float dt)
+{
+    m_simulation.update(*this, dt);
+}
+
+const BlockSimulation& ChunkManager::simulation() const
+{
+    return m_simulation;
+}
+
+const LightEngine& ChunkManager::lighting() const
+{
+    return m_lighting;
+}
+
+void ChunkManager::applyLight()
+{
+    PROFILE_ZONE("ChunkManager::applyLight");
+    m_lightUpdates.clear();
+    m_lighting.collect(m_lightUpdates);
+
+    for (const LightEngine::Update& update : m_lightUpdates)
+    {
+        Chunk *chunk = getChunk(update.index);
+        if (!chunk)
+            continue;
+        chunk->setLight(update.light.data());
+
+        // meshes of the neighbours facing changed border cells are stale too
+        const Position3& i = update.index;
+        const Position3 neighbours[6] = {{i.x - 1, i.y, i.z}, {i.x + 1, i.y, i.z},
+                                         {i.x, i.y - 1, i.z}, {i.x, i.y + 1, i.z},
+                                         {i.x, i.y, i.z - 1}, {i.x, i.y, i.z + 1}};
+        for (int f = 0; f < 6; f++)
+        {
+            if (!(update.borders & (1 << f)))
+                continue;
+            // light doesn't add faces, so neighbours without any stay as they are
+            Chunk *n = getChunk(neighbours[f]);
+            if (n && !n->empty())
+                n->setChanged();
+        }
+    }
+}
+
+void ChunkManager::meshChunk(Chunk& chunk)
+{
+    m_meshTimer.restart();
+    chunk.updateVBO();
+    // moving average, single chunks are too noisy to compare
+    float ms = m_meshTimer.getElapsedSecs() * 1000;
+    m_meshTimeMs = m_meshTimeMs == 0 ? ms : m_meshTimeMs * 0.98f + ms * 0.02f;
+
+    if (!m_pendingLoads.empty())
+    {
+        auto it = m_pendingLoads.find({chunk.getIndex().x, 0, chunk.getIndex().z});
+        if (it != m_pendingLoads.end())
+        {
+            m_loadLatencies.push_back((m_timer.getElapsedSecs() - it->second) * 1000);
+            m_pendingLoads.erase(it);
+        }
+    }
+}
+
+float ChunkManager::getMeshTimeMs() const
+{
+    return m_meshTimeMs;
+}
+
+const std::vector<float>& ChunkManager::getLoadLatencies() const
+{
+    return m_loadLatencies;
+}
+
 void ChunkManager::updateAdjacent()
 {
+    PROFILE_ZONE("ChunkManager::updateAdjacent");
     int updated = 0;
-    while (updated < m_config.world().maxExtraUpdatesPerFrame && !m_adjacentUpdateQueue.empty())
+    while (!m_adjacentUpdateQueue.empty() && (updated == 0 || m_budget.hasTime()))
     {
         Position3 &pos = m_adjacentUpdateQueue.front();
         ChunkColumn *col = getColumn(pos);
 
         if (col)
         {
+            m_budget.startTask();
             for (Chunk &c : *col)
-            c.updateVBO();
+                if (c.lit())
+                    meshChunk(c);
+            m_budget.finishTask();
             updated++;
         }
-        m_adjacentUpdateQueue.pop();
+        m_adjacentUpdateQueue.pop_front();
     }
 }
 
@@ -132,9 +281,13 @@ bool ChunkManager::tryUnloadAtPosition(const Position3& pos)
             (*columnToRender)[0].getIndex().z == pos.z)
             return false;
     }
+    logColumnChange(pos); // before erase, pos may refer to the column itself
+    m_lighting.unloadColumn(pos);
+    m_pendingLoads.erase(pos);
     auto it = m_chunkColumns.find(pos);
     assert (it != m_chunkColumns.end());
     m_chunkColumns.erase(it);
+    m_lastChunk = nullptr;
     return true;
 }
 
@@ -168,6 +321,17 @@ Chunk* ChunkManager::getChunk(const Position3& index)
     return &(*column)[index.y];
 }
 
+const Chunk* ChunkManager::getChunk(const Position3& index) const
+{
+    if(!(index.y >= 0 && index.y < m_config.world().chunksInCol))
+        return nullptr;
+
+    const ChunkColumn *column = getColumn({index.x, 0, index.z});
+    if (!column)
+        return nullptr;
+    return &(*column)[index.y];
+}
+
 ChunkColumn* ChunkManager::getColumn(const Position3& index)
 {
     auto it = m_chunkColumns.find(index);
@@ -178,67 +342,224 @@ ChunkColumn* ChunkManager::getColumn(const Position3& index)
     return &it->second;
 }
 
-uint8_t ChunkManager::get(const Position3& pos)
+const ChunkColumn* ChunkManager::getColumn(const Position3& index) const
 {
-    int cx = pos.x / Blocks::CX,
-        cy = pos.y / Blocks::CY,
-        cz = pos.z / Blocks::CZ;
+    auto it = m_chunkColumns.find(index);
 
-    int x = pos.x % Blocks::CX,
-        y = pos.y % Blocks::CY,
-        z = pos.z % Blocks::CZ;
+    if (it == m_chunkColumns.end())
+        return nullptr;
 
-    if (x < 0) {
-        cx -= 1;
-        x = Blocks::CX + x;
-    }
-    if (y < 0) {
-        cy -= 1;
-        y = Blocks::CY + y;
-    }
-    if (z < 0) {
-        cz -= 1;
-        z = Blocks::CZ + z;
+    return &it->second;
+}
+
+Chunk* ChunkManager::getChunkCached(const Position3& index)
+{
+    // consecutive lookups mostly hit the same chunk, skip the hash lookup for them
+    if (m_lastChunk && m_lastChunkIndex == index)
+        return m_lastChunk;
+
+    Chunk* chunk = getChunk(index);
+    if (chunk)
+    {
+        m_lastChunk = chunk;
+        m_lastChunkIndex = index;
     }
-//    assert(cy >= 0 && cy < m_config.world().chunksInCol);
-    assert(x >= 0 && x < Blocks::CX && y >= 0 && y < Blocks::CY && z >= 0 && z < Blocks::CZ);
+    return chunk;
+}
 
-    Chunk *ch = getChunk({cx, cy, cz});
+// Arithmetic right shift of negative values (floor division by chunk size)
+// is implementation-defined before C++20, but that's what all supported compilers do.
+
+uint8_t ChunkManager::get(const Position3& pos)
+{
+    using namespace Blocks;
+
+    Chunk *ch = getChunkCached({pos.x >> CX_SHIFT, pos.y >> CY_SHIFT, pos.z >> CZ_SHIFT});
 
     if (!ch)
         return (uint8_t)0;
 
-    return ch->getRaw({x, y, z});
+    return ch->getRaw({pos.x & CX_MASK, pos.y & CY_MASK, pos.z & CZ_MASK});
 }
 
 void ChunkManager::set(const Position3& pos, uint8_t type)
 {
-    // it's wrong for negative index... need fix
-    int cx = pos.x / Blocks::CX,
-        cy = pos.y / Blocks::CY,
-        cz = pos.z / Blocks::CZ;
-
-    int x = pos.x % Blocks::CX,
-        y = pos.y % Blocks::CY,
-        z = pos.z % Blocks::CZ;
+    using namespace Blocks;
 
-    assert(cy >= 0 && cy < m_config.world().chunksInCol);
+    Position3 index {pos.x >> CX_SHIFT, pos.y >> CY_SHIFT, pos.z >> CZ_SHIFT};
+    Position3 local {pos.x & CX_MASK, pos.y & CY_MASK, pos.z & CZ_MASK};
 
-    Chunk *ch = getChunk({cx, cy, cz});
+    Chunk *ch = getChunkCached(index);
 
     if (!ch)
         return;
 
-    ch->setRaw({x, y, z}, type);
+    ch->setRaw(local, type);
+    logChange(pos, pos, type);
+    m_simulation.activateAround(pos);
+    m_lighting.setBlock(pos, type);
+
+    // a block on the chunk border changes faces of the neighbouring chunk too
+    auto touch = [this](const Position3& i)
+    {
+        if (Chunk *n = getChunk(i))
+            n->setChanged();
+    };
+    if (local.x == 0)       touch({index.x - 1, index.y, index.z});
+    if (local.x == CX_MASK) touch({index.x + 1, index.y, index.z});
+    if (local.y == 0)       touch({index.x, index.y - 1, index.z});
+    if (local.y == CY_MASK) touch({index.x, index.y + 1, index.z});
+    if (local.z == 0)       touch({index.x, index.y, index.z - 1});
+    if (local.z == CZ_MASK) touch({index.x, index.y, index.z + 1});
+}
+
+void ChunkManager::getRegion(const Position3& min, const Position3& size, BlockRegion& region) const
+{
+    using namespace Blocks;
+
+    region.origin = min;
+    region.size = size;
+    region.blocks.assign(size.x * size.y * size.z, 0);
+
+    if (size.x <= 0 || size.y <= 0 || size.z <= 0)
+        return;
+
+    Position3 max {min.x + size.x - 1, min.y + size.y - 1, min.z + size.z - 1};
+
+    for (int cx = min.x >> CX_SHIFT; cx <= max.x >> CX_SHIFT; cx++)
+    for (int cz = min.z >> CZ_SHIFT; cz <= max.z >> CZ_SHIFT; cz++)
+    {
+        const ChunkColumn *column = getColumn({cx, 0, cz});
+        if (!column)
+            continue;
+
+        int cyMin = std::max(min.y >> CY_SHIFT, 0);
+        int cyMax = std::min(max.y >> CY_SHIFT, (int)column->size() - 1);
+
+        // overlap of the region and the column in world coordinates
+        int x0 = std::max(min.x, cx * CX), x1 = std::min(max.x, cx * CX + CX_MASK);
+        int z0 = std::max(min.z, cz * CZ), z1 = std::min(max.z, cz * CZ + CZ_MASK);
+
+        for (int cy = cyMin; cy <= cyMax; cy++)
+        {
+            const Chunk &chunk = (*column)[cy];
+            int y0 = std::max(min.y, cy * CY), y1 = std::min(max.y, cy * CY + CY_MASK);
+
+            for (int x = x0; x <= x1; x++)
+            for (int y = y0; y <= y1; y++)
+            {
+                const uint8_t *row = chunk.getRawRow(x & CX_MASK, y & CY_MASK);
+                std::memcpy(&region.blocks[region.index(x, y, z0)], row + (z0 & CZ_MASK), z1 - z0 + 1);
+            }
+        }
+    }
+}
+
+unsigned ChunkManager::getChangeCount() const
+{
+    return m_changeCount;
+}
+
+bool ChunkManager::getChange(unsigned number, WorldChange& change) const
+{
+    if (number >= m_changeCount || m_changeCount - number > ChangeLogSize)
+        return false;
+    change = m_changeLog[number % ChangeLogSize];
+    return true;
+}
+
+void ChunkManager::logChange(const Position3& min, const Position3& max, uint8_t type)
+{
+    WorldChange& change = m_changeLog[m_changeCount % ChangeLogSize];
+    change.min = min;
+    change.max = max;
+    change.type = type;
+    m_changeCount++;
+}
+
+void ChunkManager::logColumnChange(const Position3& index)
+{
+    logChange({index.x * Blocks::CX, 0, index.z * Blocks::CZ},
+              {index.x * Blocks::CX + Blocks::CX_MASK,
+               m_config.world().chunksInCol * Blocks::CY - 1,
+               index.z * Blocks::CZ + Blocks::CZ_MASK});
+}
+
+/*
+    Amanatides & Woo, "A Fast Voxel Traversal Algorithm for Ray Tracing".
+    Visits every cell the ray passes through, in order, one step per cell.
+*/
+bool ChunkManager::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                           RaycastHit& hit, bool (*isTarget)(uint8_t))
+{
+    constexpr float inf = std::numeric_limits<float>::infinity();
+
+    glm::vec3 dir = glm::normalize(direction);
+    int cell[3], step[3];
+    float tMax[3], tDelta[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        float start = std::floor(origin[i]);
+        cell[i] = (int)start;
+
+        if (dir[i] > 0)
+        {
+            step[i] = 1;
+            tDelta[i] = 1 / dir[i];
+            tMax[i] = (start + 1 - origin[i]) * tDelta[i];
+        }
+        else if (dir[i] < 0)
+        {
+            step[i] = -1;
+            tDelta[i] = -1 / dir[i];
+            tMax[i] = (origin[i] - start) * tDelta[i];
+        }
+        else
+        {
+            step[i] = 0;
+            tDelta[i] = inf;
+            tMax[i] = inf;
+        }
+    }
+
+    int normal[3] = {0, 0, 0};
+    float t = 0;
+
+    while (t <= maxDistance)
+    {
+        uint8_t block = get({cell[0], cell[1], cell[2]});
+        if (isTarget(block))
+        {
+            hit.block = {cell[0], cell[1], cell[2]};
+            hit.normal = {normal[0], normal[1], normal[2]};
+            hit.distance = t;
+            hit.type = block;
+            return true;
+        }
+        // step into the neighbour whose boundary is crossed first
+        int axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2)
+                                     : (tMax[1] < tMax[2] ? 1 : 2);
+        t = tMax[axis];
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+
+        normal[0] = normal[1] = normal[2] = 0;
+        normal[axis] = -step[axis];
+    }
+    return false;
 }
 
 void ChunkManager::render()
 {
+    PROFILE_ZONE("ChunkManager::render");
     m_texture->bind();
     m_shader->use();
-    m_shader->setFloat("time", m_timer.getElapsedSecs());
+    m_shader->setFloat("time", m_animationTime);
+    auto modelUniform = m_shader->uniform<glm::mat4>("model");
 
     int chunksUpdated = 0;
+    m_translucentList.clear();
 
     for (auto col : m_renderList)
     for (Chunk &chunk : *col)
@@ -254,16 +575,114 @@ void ChunkManager::render()
             continue;
 
         glm::mat4 model = glm::translate(glm::mat4(1), min);
-        m_shader->setMat4("model", &model[0][0]);
+        m_shader->set(modelUniform, model);
 
-        if (chunk.changed() && chunksUpdated < m_config.world().maxUpdatesPerFrame)
+        // wait for the light so that a new chunk is meshed once
+        if (chunk.changed() && chunk.lit() && (chunksUpdated == 0 || m_budget.hasTime()))
         {
-            chunk.updateVBO();
+            m_budget.startTask();
+            meshChunk(chunk);
+            m_budget.finishTask();
             chunksUpdated++;
         }
         chunk.render();
+
+        if (chunk.hasTranslucent())
+        {
+            glm::vec3 d = (min + max) * 0.5f - m_cameraPosition;
+            m_translucentList.emplace_back(glm::dot(d, d), &chunk);
+        }
+    }
+}
+
+void ChunkManager::renderTranslucent()
+{
+    PROFILE_ZONE("ChunkManager::renderTranslucent");
+    if (m_translucentList.empty())
+        return;
+
+    // back to front between chunks; faces inside a chunk are sorted by the chunk itself
+    std::sort(m_translucentList.begin(), m_translucentList.end(),
+              [](const std::pair<float, Chunk*>& a, const std::pair<float, Chunk*>& b)
+    {
+        return a.first > b.first;
+    });
+
+    Position3 cameraChunk {(int)std::floor(m_cameraPosition.x) >> Blocks::CX_SHIFT,
+                           (int)std::floor(m_cameraPosition.y) >> Blocks::CY_SHIFT,
+                           (int)std::floor(m_cameraPosition.z) >> Blocks::CZ_SHIFT};
+
+    m_texture->bind();
+    m_translucentShader->use();
+    m_translucentShader->setFloat("time", m_animationTime);
+    auto modelUniform = m_translucentShader->uniform<glm::mat4>("model");
+
+    GLState::setEnabled(GL_BLEND, true);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::depthMask(false);
+
+    for (const auto& item : m_translucentList)
+    {
+        Chunk& chunk = *item.second;
+        auto p = chunk.getIndex();
+        glm::vec3 min = glm::vec3{p.x * Blocks::CX, p.y * Blocks::CY, p.z * Blocks::CZ};
+
+        glm::mat4 model = glm::translate(glm::mat4(1), min);
+        m_translucentShader->set(modelUniform, model);
+
+        chunk.sortTranslucent(cameraChunk, m_cameraPosition - min);
+        chunk.renderTranslucent();
+    }
+
+    GLState::depthMask(true);
+    GLState::setEnabled(GL_BLEND, false);
+}
+
+#ifdef DEBUG_DRAW
+void ChunkManager::drawDebug() const
+{
+    using namespace DebugDraw;
+    const float height = m_config.world().chunksInCol * Blocks::CY;
+    auto columnBox = [height](const Position3& index)
+    {
+        glm::vec3 min {index.x * Blocks::CX, 0, index.z * Blocks::CZ};
+        return Geom::AABB(min, min + glm::vec3(Blocks::CX, height, Blocks::CZ));
+    };
+
+    // columns in range that haven't been generated yet
+    for (const auto& i : m_lookupIndexBuffer)
+    {
+        Position3 index {(m_oldPlayerPos.x >> Blocks::CX_SHIFT) + i.first, 0,
+                         (m_oldPlayerPos.z >> Blocks::CZ_SHIFT) + i.second};
+        if (m_chunkColumns.find(index) == m_chunkColumns.end())
+            box(columnBox(index), Color::PendingLoad);
+    }
+    for (const Position3& index : m_adjacentUpdateQueue)
+        box(columnBox(index), Color::Queued);
+
+    // chunks fully inside the frustum and up to date are left out
+    for (const ChunkColumn* col : m_renderList)
+    for (const Chunk& chunk : *col)
+    {
+        auto p = chunk.getIndex();
+        glm::vec3 min {p.x * Blocks::CX, p.y * Blocks::CY, p.z * Blocks::CZ};
+        Geom::AABB bounds {min, min + glm::vec3{Blocks::CX, Blocks::CY, Blocks::CZ}};
+
+        if (chunk.changed())
+            box(bounds, Color::Dirty);
+        else if (chunk.empty())
+            continue;
+        else
+        {
+            int result = m_frustrum.checkBox(bounds);
+            if (result == Frustrum::Outside)
+                box(bounds, Color::Culled);
+            else if (result == Frustrum::Intersect)
+                box(bounds, Color::Intersect);
+        }
     }
 }
+#endif
 
 void ChunkManager::fillLookupIndexBuffer()
 { /* square spiral lookup */
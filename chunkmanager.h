@@ -1,14 +1,22 @@
 #ifndef SUPERCHUNK_H_INCLUDED
 #define SUPERCHUNK_H_INCLUDED
 
+#include <deque>
 #include <unordered_map>
 #include <vector>
 #include <queue>
 #include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
 
 #include "chunk.h"
+#include "blockregion.h"
+#include "terrain/blocksimulation.h"
+#include "terrain/heightmapprovider.h"
+#include "terrain/lightengine.h"
+#include "graphics/debugdraw.h"
 #include "graphics/renderable.h"
 #include "utils/timer.h"
+#include "utils/framebudget.h"
 
 
 using ChunkColumn = std::vector<Chunk>;
@@ -17,43 +25,120 @@ using ChunkColumnMap = std::unordered_map<Position3, ChunkColumn>;
 class Frustrum;
 class Settings;
 
+// Box of blocks changed by an edit or a column (un)load. For single block edits
+// min == max and type holds the new block.
+struct WorldChange
+{
+    Position3   min, max; // inclusive
+    uint8_t     type {0};
+};
+
+struct RaycastHit
+{
+    Position3   block;          // world position of the hit block
+    Position3   normal;         // face the ray entered through, block + normal is the cell in front of it
+    float       distance {0};   // from the ray origin to the entry point
+    uint8_t     type {0};
+};
+
 struct ChunkManager : public Renderable, public WithTexture, public WithShader, Transformable
 {
     ChunkManager(Frustrum& frustrum);
 
     uint8_t         get(const Position3& pos);
     void            set(const Position3& pos, uint8_t type);
+    // copies blocks of the box [min, min + size) into region, missing chunks read as empty
+    void            getRegion(const Position3& min, const Position3& size, BlockRegion& region) const;
+
+    // Changes are numbered from 0; a change can be read back until ChangeLogSize newer ones
+    // have been made. Used by caches of world data to refresh incrementally.
+    unsigned        getChangeCount() const;
+    bool            getChange(unsigned number, WorldChange& change) const;
+
+    // walks the block grid along the ray, returns the first block accepted by isTarget
+    bool            raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                            RaycastHit& hit, bool (*isTarget)(uint8_t) = Blocks::isSolid);
 
     void            update(const Position3 &playerPosition);
-    void            render();
+    // generates all columns with x and z indices in [min, max] at once, without light or
+    // meshes; fill sets the blocks of a new column
+    void            generateRegion(const Position3& min, const Position3& max,
+                                   void (*fill)(ChunkColumn&) = HeightMapProvider::fillChunkColumn);
+    // steps falling sand and flowing water, called from the fixed physics tick
+    void            simulate(float dt);
+    const BlockSimulation& simulation() const;
+    const LightEngine& lighting() const;
+    void            render();               // opaque pass
+    void            renderTranslucent();    // water and glass, after all opaque geometry
+#ifdef DEBUG_DRAW
+    // chunk bounds coloured by what streaming, culling and meshing think of them
+    void            drawDebug() const;
+#endif
 
     void            setTransform(const glm::mat4& transform);
+    void            setCameraPosition(const glm::vec3& position);
+    void            setAnimationTime(double secs);  // clock of the water and other shader effects
+    void            setTranslucentShader(Shader& shader);
 
     Chunk*          getChunk(const Position3& index);
+    const Chunk*    getChunk(const Position3& index) const;
+
+    FrameBudget&    streamingBudget();
+    // streaming without a time limit and light waited for each update, so that the
+    // world after a given number of updates is the same on any machine
+    void            setDeterministic(bool deterministic);
+    float           getMeshTimeMs() const; // average time to mesh one chunk
+    // ms from generating each column to meshing the first of its chunks
+    const std::vector<float>& getLoadLatencies() const;
 
 private:
     ChunkColumn*    getColumn(const Position3 &index);
+    const ChunkColumn* getColumn(const Position3 &index) const;
+    Chunk*          getChunkCached(const Position3& index);
     bool            tryUnloadAtPosition(const Position3 &pos);
     void            unloadSpareChunkColumns();
     void            updateAdjacent();
+    void            applyLight();
+    void            meshChunk(Chunk& chunk);
 
     void            fillLookupIndexBuffer();
+    void            logChange(const Position3& min, const Position3& max, uint8_t type = 0);
+    void            logColumnChange(const Position3& index);
 
 private:
     ChunkColumnMap              m_chunkColumns;
     std::vector<ChunkColumn*>   m_renderList;
+    std::vector<std::pair<float, Chunk*>> m_translucentList; // visible chunks with water or glass
+    Shader*                     m_translucentShader {nullptr};
+    glm::vec3                   m_cameraPosition {0, 0, 0};
+    float                       m_animationTime {0};
     std::queue<ChunkColumn*>    m_loadedQueue;
-    std::queue<Position3>       m_adjacentUpdateQueue;
+    std::deque<Position3>       m_adjacentUpdateQueue;
     int                         m_loadRadius,
                                 m_chunkColsLoaded {0};
     Position3                   m_oldPlayerPos;
 
+    Chunk*                      m_lastChunk {nullptr}; // last chunk hit by get/set
+    Position3                   m_lastChunkIndex;
+
     bool                        m_loadingDone {false};
+    bool                        m_deterministic {false};
     Frustrum&                   m_frustrum;
     Settings&                   m_config;
-    Timer                       m_timer;
+    Timer                       m_timer, m_meshTimer;
+    float                       m_meshTimeMs {0};
+    std::unordered_map<Position3, double> m_pendingLoads; // column -> when it was generated
+    std::vector<float>          m_loadLatencies;
+    FrameBudget                 m_budget;
+    BlockSimulation             m_simulation;
+    LightEngine                 m_lighting;
+    std::vector<LightEngine::Update> m_lightUpdates;
 
     std::vector<std::pair<int, int>> m_lookupIndexBuffer;
+
+    static constexpr unsigned   ChangeLogSize = 256;
+    WorldChange                 m_changeLog[ChangeLogSize];
+    unsigned                    m_changeCount {0};
 };
 
 #endif // SUPERCHUNK_H_INCLUDED
@@ -0,0 +1,161 @@
+#include "assetloader.h"
+#include "shader.h"
+#include "utils/resourcemanager.h"
+#include "utils/threadpool.h"
+#include "utils/utils.h"
+
+#include <iomanip>
+#include <iostream>
+
+void AssetLoader::addShader(const std::string& name, const std::string& vertexFile, const std::string& fragmentFile,
+                            const std::string& defines, ShaderSetup setup)
+{
+    auto asset = std::make_unique<Asset>();
+    asset->kind = Asset::ShaderProgram;
+    asset->name = name;
+    asset->files = {vertexFile, fragmentFile};
+    asset->defines = defines;
+    asset->setup = std::move(setup);
+    m_assets.emplace_back(std::move(asset));
+}
+
+void AssetLoader::addTexture(const std::string& name, const std::string& file, bool flipVertically)
+{
+    auto asset = std::make_unique<Asset>();
+    asset->kind = Asset::Texture2D;
+    asset->name = name;
+    asset->files = {file};
+    asset->flip = flipVertically;
+    m_assets.emplace_back(std::move(asset));
+}
+
+void AssetLoader::addTextureArray(const std::string& name, const std::string& file, bool flipVertically)
+{
+    addTexture(name, file, flipVertically);
+    m_assets.back()->kind = Asset::TextureArray;
+}
+
+void AssetLoader::addCubeMap(const std::string& name, const std::array<std::string, 6>& files, bool flipVertically)
+{
+    auto asset = std::make_unique<Asset>();
+    asset->kind = Asset::CubeMap;
+    asset->name = name;
+    asset->files.assign(files.begin(), files.end());
+    asset->flip = flipVertically;
+    asset->parts = 6; // faces decode in parallel
+    m_assets.emplace_back(std::move(asset));
+}
+
+void AssetLoader::run()
+{
+    m_clock.restart();
+
+    for (auto& asset : m_assets)
+    {
+        Asset* a = asset.get();
+        a->images.resize(a->kind == Asset::ShaderProgram ? 0 : a->parts);
+        a->started = 0;
+        a->pending = a->parts;
+        for (int part = 0; part < a->parts; part++)
+        {
+            ThreadPool::get().submit([this, a, part]
+            {
+                read(*a, part);
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (--a->pending > 0)
+                    return;
+                a->readEnd = m_clock.getElapsedSecs();
+                m_ready.push_back(a);
+                m_cv.notify_one();
+            });
+        }
+    }
+
+    // create in completion order, so that a slow decode doesn't hold up the rest
+    for (size_t created = 0; created < m_assets.size(); created++)
+    {
+        Asset* a;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return !m_ready.empty(); });
+            a = m_ready.front();
+            m_ready.pop_front();
+        }
+        create(*a);
+    }
+    m_totalSecs = m_clock.getElapsedSecs();
+}
+
+void AssetLoader::read(Asset& asset, int part)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (asset.started++ == 0)
+            asset.readStart = m_clock.getElapsedSecs();
+    }
+    switch (asset.kind)
+    {
+    case Asset::ShaderProgram:
+        for (const auto& file : asset.files)
+            asset.sources.emplace_back(Utils::getTextFromFile(file.c_str()));
+        break;
+    case Asset::Texture2D:
+    case Asset::TextureArray:
+        asset.images[0] = TextureLoader::decode(asset.files[0], 4, asset.flip);
+        break;
+    case Asset::CubeMap:
+        asset.images[part] = TextureLoader::decode(asset.files[part], 3, asset.flip);
+        break;
+    }
+}
+
+void AssetLoader::create(Asset& asset)
+{
+    asset.createStart = m_clock.getElapsedSecs();
+    switch (asset.kind)
+    {
+    case Asset::ShaderProgram:
+    {
+        auto shader = std::make_unique<Shader>();
+        shader->loadFromSource(std::move(asset.sources[0]), std::move(asset.sources[1]), asset.defines);
+        if (asset.setup)
+            asset.setup(*shader);
+        ResourceManager::shaders().insert(asset.name, std::move(shader));
+        break;
+    }
+    case Asset::Texture2D:
+        ResourceManager::textures().insert(asset.name, TextureLoader::createTexture(asset.images[0]));
+        break;
+    case Asset::TextureArray:
+        ResourceManager::textures().insert(asset.name, TextureLoader::createTextureArray(asset.images[0]));
+        break;
+    case Asset::CubeMap:
+    {
+        std::array<Image, 6> faces;
+        for (int i = 0; i < 6; i++)
+            faces[i] = std::move(asset.images[i]);
+        ResourceManager::textures().insert(asset.name, TextureLoader::createCubeMap(faces));
+        break;
+    }
+    }
+    asset.sources.clear();
+    asset.images.clear();
+    asset.createEnd = m_clock.getElapsedSecs();
+}
+
+void AssetLoader::printTimeline(std::ostream& out) const
+{
+    auto ms = [](double secs) { return secs * 1000; };
+
+    out << "Startup assets (ms since start: read on worker | created on GL thread)\n";
+    auto precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+    for (const auto& a : m_assets)
+    {
+        out << "  " << std::left << std::setw(20) << a->name << std::right
+            << std::setw(8) << ms(a->readStart) << " - " << std::setw(6) << ms(a->readEnd) << " | "
+            << std::setw(6) << ms(a->createStart) << " - " << std::setw(6) << ms(a->createEnd) << '\n';
+    }
+    out << "  total " << ms(m_totalSecs) << " ms on " << ThreadPool::get().size() << " workers" << std::endl;
+    out << std::defaultfloat << std::setprecision(precision);
+}
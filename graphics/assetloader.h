@@ -0,0 +1,79 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _GLIBCXX_HAS_GTHREADS
+#include <mingw.mutex.h>
+#include <mingw.condition_variable.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#include "textureloader.h"
+#include "utils/noncopyable.h"
+#include "utils/timer.h"
+
+class Shader;
+
+/*
+    Startup asset pipeline. Files are read and images decoded on the thread pool,
+    each asset is created on the GL thread as soon as its data is ready and put into
+    the ResourceManager under its name.
+*/
+class AssetLoader : NonCopyable
+{
+public:
+    using ShaderSetup = std::function<void(Shader&)>;
+
+    void    addShader(const std::string& name, const std::string& vertexFile, const std::string& fragmentFile,
+                      const std::string& defines = "", ShaderSetup setup = {});
+    void    addTexture(const std::string& name, const std::string& file, bool flipVertically = true);
+    void    addTextureArray(const std::string& name, const std::string& file, bool flipVertically = true);
+    void    addCubeMap(const std::string& name, const std::array<std::string, 6>& files, bool flipVertically = true);
+
+    // returns when everything added so far is loaded
+    void    run();
+
+    // when each asset was read and created, relative to the start of run()
+    void    printTimeline(std::ostream& out) const;
+
+private:
+    struct Asset
+    {
+        enum Kind {ShaderProgram, Texture2D, TextureArray, CubeMap} kind;
+        std::string                 name;
+        std::vector<std::string>    files;
+        std::string                 defines;
+        bool                        flip {true};
+        ShaderSetup                 setup;
+
+        // filled on the workers, one task per part
+        std::vector<std::string>    sources;
+        std::vector<Image>          images;
+        int                         parts {1};
+        int                         started {0}, pending {0}; // parts, guarded by m_mutex
+
+        double  readStart {0}, readEnd {0}, createStart {0}, createEnd {0};
+    };
+
+    void    read(Asset& asset, int part);
+    void    create(Asset& asset);
+
+private:
+    std::vector<std::unique_ptr<Asset>> m_assets;
+    std::deque<Asset*>      m_ready;
+    std::mutex              m_mutex;
+    std::condition_variable m_cv;
+    Timer                   m_clock;
+    double                  m_totalSecs {0};
+};
+
+#endif // ASSETLOADER_H
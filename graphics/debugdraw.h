@@ -0,0 +1,44 @@
+#ifndef DEBUGDRAW_H
+#define DEBUGDRAW_H
+
+#include <glm/vec3.hpp>
+
+#include "maths/geometry.h"
+
+// Debug visualisation is part of debug builds only; without DEBUG_DRAW every call
+// below is an empty inline and the code behind it is not compiled
+#ifndef NDEBUG
+    #define DEBUG_DRAW
+#endif
+
+#ifdef DEBUG_DRAW
+    #include "linebatch.h"
+#endif
+
+namespace DebugDraw
+{
+namespace Color
+{
+const glm::vec3 Culled      {0.35f, 0.35f, 0.35f};
+const glm::vec3 Intersect   {1.0f, 0.85f, 0.1f};
+const glm::vec3 Dirty       {1.0f, 0.15f, 0.15f};
+const glm::vec3 Queued      {0.9f, 0.2f, 0.9f};
+const glm::vec3 PendingLoad {0.2f, 0.5f, 1.0f};
+}
+
+#ifdef DEBUG_DRAW
+inline void line(const glm::vec3& a, const glm::vec3& b, const glm::vec3& color)
+{
+    LineBatch::get().addLine(a, b, color);
+}
+inline void box(const Geom::AABB& box, const glm::vec3& color)
+{
+    LineBatch::get().addBox(box, color);
+}
+#else
+inline void line(const glm::vec3&, const glm::vec3&, const glm::vec3&) {}
+inline void box(const Geom::AABB&, const glm::vec3&) {}
+#endif
+}
+
+#endif // DEBUGDRAW_H
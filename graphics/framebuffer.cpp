@@ -0,0 +1,65 @@
+#include "framebuffer.h"
+
+#include <cstring>
+#include <glad/glad.h>
+
+Framebuffer::~Framebuffer()
+{
+    release();
+}
+
+void Framebuffer::release()
+{
+    if (m_fbo)
+    {
+        glDeleteFramebuffers(1, &m_fbo);
+        glDeleteRenderbuffers(1, &m_color);
+        glDeleteRenderbuffers(1, &m_depth);
+        m_fbo = m_color = m_depth = 0;
+    }
+}
+
+bool Framebuffer::create(int width, int height)
+{
+    release();
+    m_width = width;
+    m_height = height;
+
+    glGenRenderbuffers(1, &m_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &m_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void Framebuffer::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+}
+
+void Framebuffer::readPixels(std::vector<uint8_t>& rgba) const
+{
+    size_t rowSize = m_width * 4;
+    rgba.resize(rowSize * m_height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+    // GL starts at the bottom row
+    std::vector<uint8_t> row(rowSize);
+    for (int y = 0; y < m_height / 2; y++)
+    {
+        uint8_t* top = &rgba[y * rowSize];
+        uint8_t* bottom = &rgba[(m_height - 1 - y) * rowSize];
+        memcpy(row.data(), top, rowSize);
+        memcpy(top, bottom, rowSize);
+        memcpy(bottom, row.data(), rowSize);
+    }
+}
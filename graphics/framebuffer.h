@@ -0,0 +1,32 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/noncopyable.h"
+
+// Offscreen target with RGBA8 colour and 24-bit depth, for contexts without a window
+class Framebuffer : NonCopyable
+{
+public:
+    Framebuffer() = default;
+    ~Framebuffer();
+
+    bool create(int width, int height);     // false if incomplete
+    void bind() const;
+
+    // colour attachment, rows top to bottom
+    void readPixels(std::vector<uint8_t>& rgba) const;
+
+    int width() const   {return m_width;}
+    int height() const  {return m_height;}
+
+private:
+    void release();
+
+    unsigned int    m_fbo {0}, m_color {0}, m_depth {0};
+    int             m_width {0}, m_height {0};
+};
+
+#endif // FRAMEBUFFER_H
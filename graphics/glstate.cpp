@@ -0,0 +1,191 @@
+#include "glstate.h"
+#include "utils/drawcalltrack.h"
+
+namespace GLState
+{
+namespace
+{
+constexpr GLuint Unknown = ~0u;
+constexpr unsigned MaxUnits = 8;
+
+// texture targets tracked per unit
+constexpr GLenum TextureTargets[] = {GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP};
+constexpr int TargetCount = sizeof(TextureTargets) / sizeof(TextureTargets[0]);
+
+struct State
+{
+    GLuint  program;
+    GLuint  vao;
+    GLuint  arrayBuffer;
+    GLuint  activeUnit;
+    GLuint  textures[MaxUnits][TargetCount];
+    GLuint  blend, depthTest, cullFace;   // 0, 1 or Unknown
+    GLuint  blendSrc, blendDst;
+    GLuint  depthFunc;
+    GLuint  depthMask;
+    GLuint  cullMode;
+} state;
+
+bool initialized = false;
+
+void ensureInitialized()
+{
+    if (!initialized)
+        invalidate();
+}
+
+// true if the call has to be issued; stores the new value
+bool change(GLuint& current, GLuint value)
+{
+    ensureInitialized();
+    bool changed = current != value;
+    DrawCallTrack::countStateChange(!changed);
+    current = value;
+    return changed;
+}
+
+int targetIndex(GLenum target)
+{
+    for (int i = 0; i < TargetCount; i++)
+        if (TextureTargets[i] == target)
+            return i;
+    return -1;
+}
+
+GLuint* capState(GLenum cap)
+{
+    switch (cap)
+    {
+    case GL_BLEND:      return &state.blend;
+    case GL_DEPTH_TEST: return &state.depthTest;
+    case GL_CULL_FACE:  return &state.cullFace;
+    }
+    return nullptr;
+}
+}
+
+void invalidate()
+{
+    state.program = state.vao = state.arrayBuffer = state.activeUnit = Unknown;
+    for (auto& unit : state.textures)
+        for (auto& texture : unit)
+            texture = Unknown;
+    state.blend = state.depthTest = state.cullFace = Unknown;
+    state.blendSrc = state.blendDst = Unknown;
+    state.depthFunc = state.depthMask = state.cullMode = Unknown;
+    initialized = true;
+}
+
+void useProgram(GLuint program)
+{
+    if (change(state.program, program))
+        glUseProgram(program);
+}
+
+void bindVertexArray(GLuint vao)
+{
+    if (change(state.vao, vao))
+        glBindVertexArray(vao);
+}
+
+void bindBuffer(GLenum target, GLuint buffer)
+{
+    if (target != GL_ARRAY_BUFFER)
+    {
+        DrawCallTrack::countStateChange(false);
+        glBindBuffer(target, buffer);
+    }
+    else if (change(state.arrayBuffer, buffer))
+        glBindBuffer(target, buffer);
+}
+
+void bindTexture(unsigned unit, GLenum target, GLuint texture)
+{
+    ensureInitialized();
+    int t = targetIndex(target);
+    if (unit < MaxUnits && t >= 0 && state.textures[unit][t] == texture)
+    {
+        DrawCallTrack::countStateChange(true);
+        return;
+    }
+    if (change(state.activeUnit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    DrawCallTrack::countStateChange(false);
+    glBindTexture(target, texture);
+    if (unit < MaxUnits && t >= 0)
+        state.textures[unit][t] = texture;
+}
+
+void setEnabled(GLenum cap, bool enabled)
+{
+    ensureInitialized();
+    GLuint* current = capState(cap);
+    if (current && !change(*current, enabled))
+        return;
+    if (!current)
+        DrawCallTrack::countStateChange(false);
+    if (enabled)
+        glEnable(cap);
+    else
+        glDisable(cap);
+}
+
+void blendFunc(GLenum src, GLenum dst)
+{
+    bool srcChanged = change(state.blendSrc, src);
+    bool dstChanged = state.blendDst != dst;
+    state.blendDst = dst;
+    if (srcChanged || dstChanged)
+        glBlendFunc(src, dst);
+}
+
+void depthFunc(GLenum func)
+{
+    if (change(state.depthFunc, func))
+        glDepthFunc(func);
+}
+
+void depthMask(bool write)
+{
+    if (change(state.depthMask, write))
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void cullFace(GLenum mode)
+{
+    if (change(state.cullMode, mode))
+        glCullFace(mode);
+}
+
+// GL unbinds deleted objects, and their names may come back from the next glGen*
+
+void deleteProgram(GLuint program)
+{
+    glDeleteProgram(program);
+    if (state.program == program)
+        state.program = Unknown;
+}
+
+void deleteVertexArray(GLuint vao)
+{
+    glDeleteVertexArrays(1, &vao);
+    if (state.vao == vao)
+        state.vao = 0;
+}
+
+void deleteBuffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
+    if (state.arrayBuffer == buffer)
+        state.arrayBuffer = 0;
+}
+
+void deleteTexture(GLuint texture)
+{
+    glDeleteTextures(1, &texture);
+    for (auto& unit : state.textures)
+        for (auto& bound : unit)
+            if (bound == texture)
+                bound = 0;
+}
+}
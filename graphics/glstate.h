@@ -0,0 +1,33 @@
+#ifndef GLSTATE_H_INCLUDED
+#define GLSTATE_H_INCLUDED
+
+#include "glad/glad.h"
+
+/*
+    Shadow copy of the GL binding and fixed-function state the renderer touches.
+    A call that would set what is already set is skipped, both kinds are counted
+    by DrawCallTrack. All binds and deletes of these objects have to go through
+    here, otherwise the copy goes stale; invalidate() forgets everything.
+*/
+namespace GLState
+{
+void useProgram(GLuint program);
+void bindVertexArray(GLuint vao);
+void bindBuffer(GLenum target, GLuint buffer);  // array buffer is tracked, the rest belongs to the VAO
+void bindTexture(unsigned unit, GLenum target, GLuint texture);
+
+void setEnabled(GLenum cap, bool enabled);      // GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE
+void blendFunc(GLenum src, GLenum dst);
+void depthFunc(GLenum func);
+void depthMask(bool write);
+void cullFace(GLenum mode);
+
+void deleteProgram(GLuint program);
+void deleteVertexArray(GLuint vao);
+void deleteBuffer(GLuint buffer);
+void deleteTexture(GLuint texture);
+
+void invalidate();
+}
+
+#endif // GLSTATE_H_INCLUDED
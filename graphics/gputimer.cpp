@@ -0,0 +1,102 @@
+#include "gputimer.h"
+
+#include <algorithm>
+#include <glad/glad.h>
+#include <iostream>
+
+GpuTimer::~GpuTimer()
+{
+    for (auto& pass : m_passes)
+        glDeleteQueries(FramesInFlight, pass.queries);
+}
+
+void GpuTimer::initialize()
+{
+    // core since 3.3, but a driver may still implement it with a zero-bit counter
+    GLint bits = 0;
+    if (GLAD_GL_VERSION_3_3)
+        glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+    glGetError(); // an unknown target is not worth reporting
+
+    m_supported = bits > 0;
+    if (!m_supported)
+        std::cout << "GPU timer queries unavailable, pass timings disabled" << std::endl;
+}
+
+bool GpuTimer::isSupported() const
+{
+    return m_supported;
+}
+
+void GpuTimer::beginFrame()
+{
+    if (!m_supported || !Profiler::isEnabled())
+        return;
+    m_frame = (m_frame + 1) % FramesInFlight;
+    collect(m_frame);
+}
+
+void GpuTimer::collect(int frame)
+{
+    for (size_t i = 0; i < m_passes.size(); i++)
+    {
+        Pass& pass = m_passes[i];
+        if (pass.submitted[frame] == 0)
+            continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(pass.queries[frame], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(pass.queries[frame], GL_QUERY_RESULT, &ns);
+            float ms = ns / 1e6f;
+            m_stats[i].ms = m_stats[i].ms * 0.9f + ms * 0.1f;
+
+            double start = pass.submitted[frame];
+            if (!m_events.empty())
+                start = std::max(start, m_events.back().end);
+            m_events.push_back({pass.name, start, start + ns / 1e9, 0});
+            if (m_events.size() > MaxEvents)
+                m_events.pop_front();
+        }
+        // a result still pending is dropped, the query gets reused below
+        pass.submitted[frame] = 0;
+    }
+}
+
+void GpuTimer::begin(const char* name)
+{
+    if (!m_supported || m_active >= 0 || !Profiler::isEnabled())
+        return;
+
+    auto it = std::find_if(m_passes.begin(), m_passes.end(), [name](const Pass& p) { return p.name == name; });
+    if (it == m_passes.end())
+    {
+        m_passes.push_back({name});
+        glGenQueries(FramesInFlight, m_passes.back().queries);
+        m_stats.push_back({name});
+        it = m_passes.end() - 1;
+    }
+    m_active = it - m_passes.begin();
+    it->submitted[m_frame] = Profiler::get().now();
+    glBeginQuery(GL_TIME_ELAPSED, it->queries[m_frame]);
+}
+
+void GpuTimer::end()
+{
+    if (m_active < 0)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    m_active = -1;
+}
+
+const std::vector<GpuTimer::PassStat>& GpuTimer::getPassStats() const
+{
+    return m_stats;
+}
+
+std::vector<Profiler::Event> GpuTimer::getEvents() const
+{
+    return {m_events.begin(), m_events.end()};
+}
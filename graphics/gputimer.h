@@ -0,0 +1,65 @@
+#ifndef GPUTIMER_H_INCLUDED
+#define GPUTIMER_H_INCLUDED
+
+#include <deque>
+#include <vector>
+
+#include "utils/noncopyable.h"
+#include "utils/profiler.h"
+
+/*
+    GL_TIME_ELAPSED queries around render passes. Each pass has one query per
+    frame in flight; a frame reads the results of the one that last used the same
+    set, and only if they are already available, so the CPU never waits for the
+    GPU. Without timer queries (some software drivers report zero counter bits)
+    every call is a no-op.
+*/
+class GpuTimer : NonCopyable
+{
+public:
+    struct PassStat
+    {
+        const char* name;
+        float       ms {0};     // smoothed
+    };
+
+    GpuTimer() = default;
+    ~GpuTimer();
+
+    void initialize();          // needs the GL context
+    bool isSupported() const;
+
+    // only time anything while the profiler is enabled; passes can't nest
+    void beginFrame();
+    void begin(const char* name);   // string literal, it identifies the pass
+    void end();
+
+    const std::vector<PassStat>& getPassStats() const;
+
+    // recent passes for the trace, placed at the CPU time they were submitted
+    // since elapsed queries only measure durations
+    std::vector<Profiler::Event> getEvents() const;
+
+private:
+    static constexpr int FramesInFlight = 2;
+    static constexpr size_t MaxEvents = 4096;
+
+    struct Pass
+    {
+        const char* name;
+        unsigned    queries[FramesInFlight] {};
+        double      submitted[FramesInFlight] {};   // profiler clock, 0 if not issued
+    };
+
+    void collect(int frame);
+
+private:
+    bool                m_supported {false};
+    int                 m_frame {0};
+    int                 m_active {-1};
+    std::vector<Pass>   m_passes;
+    std::vector<PassStat> m_stats;
+    std::deque<Profiler::Event> m_events;
+};
+
+#endif // GPUTIMER_H_INCLUDED
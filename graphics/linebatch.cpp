@@ -0,0 +1,88 @@
+#include "linebatch.h"
+#include "glstate.h"
+#include "maths/geometry.h"
+#include "utils/drawcalltrack.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <glad/glad.h>
+
+LineBatch& LineBatch::get()
+{
+    static LineBatch instance;
+    return instance;
+}
+
+void LineBatch::initialize()
+{
+    if (m_vao == 0)
+    {
+        glGenVertexArrays(1, &m_vao);
+        GLState::bindVertexArray(m_vao);
+        glGenBuffers(1, &m_vbo);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+        glEnableVertexAttribArray(1);
+        GLState::bindVertexArray(0);
+    }
+}
+
+void LineBatch::release()
+{
+    GLState::deleteBuffer(m_vbo);
+    GLState::deleteVertexArray(m_vao);
+    m_vao = m_vbo = 0;
+    m_capacity = 0;
+}
+
+void LineBatch::addLine(const glm::vec3& a, const glm::vec3& b, const glm::vec3& color)
+{
+    glm::tvec4<uint8_t> c {(uint8_t)(color.x * 255), (uint8_t)(color.y * 255), (uint8_t)(color.z * 255), 255};
+    m_vertices.push_back({a, c});
+    m_vertices.push_back({b, c});
+}
+
+void LineBatch::addBox(const Geom::AABB& box, const glm::vec3& color)
+{
+    const glm::vec3& l = box.min;
+    const glm::vec3& h = box.max;
+    glm::vec3 corners[8] = {
+        {l.x, l.y, l.z}, {h.x, l.y, l.z}, {h.x, h.y, l.z}, {l.x, h.y, l.z},
+        {l.x, l.y, h.z}, {h.x, l.y, h.z}, {h.x, h.y, h.z}, {l.x, h.y, h.z}
+    };
+    constexpr int edges[12][2] = {
+        {0, 1}, {1, 2}, {2, 3}, {3, 0},
+        {4, 5}, {5, 6}, {6, 7}, {7, 4},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+    for (const auto& e : edges)
+        addLine(corners[e[0]], corners[e[1]], color);
+}
+
+void LineBatch::setTransform(const glm::mat4& transform)
+{
+    m_shader->use();
+    m_shader->setMat4("proj_view", &transform[0][0]);
+}
+
+void LineBatch::render()
+{
+    if (m_vertices.empty())
+        return;
+
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    if (m_vertices.size() > m_capacity)
+        m_capacity = std::max(m_vertices.size(), m_capacity * 2);
+    // orphan last frame's storage, then fill the front of the new one
+    glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_vertices.size() * sizeof(Vertex), m_vertices.data());
+
+    m_shader->use();
+    GLState::bindVertexArray(m_vao);
+    glLineWidth(2);
+    glDrawArrays_(GL_LINES, 0, m_vertices.size());
+
+    m_vertices.clear();
+}
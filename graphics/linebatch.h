@@ -0,0 +1,50 @@
+#ifndef LINEBATCH_H
+#define LINEBATCH_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "renderable.h"
+#include "utils/noncopyable.h"
+
+namespace Geom {
+struct AABB;
+}
+
+/*
+    Lines collected from anywhere during the frame (block outline, debug boxes),
+    uploaded into one persistent buffer and drawn with a single call by render(),
+    which also empties the batch.
+*/
+class LineBatch : public Renderable, public WithShader, Transformable, NonCopyable
+{
+public:
+    static LineBatch& get();
+
+    void initialize();
+    void release();     // while the GL context is still there
+
+    void addLine(const glm::vec3& a, const glm::vec3& b, const glm::vec3& color);
+    void addBox(const Geom::AABB& box, const glm::vec3& color);
+
+    void setTransform(const glm::mat4& transform);
+    void render();
+
+private:
+    LineBatch() = default;
+
+    struct Vertex
+    {
+        glm::vec3               pos;
+        glm::tvec4<uint8_t>     color;
+    };
+
+    std::vector<Vertex> m_vertices;
+    unsigned int        m_vao {0}, m_vbo {0};
+    size_t              m_capacity {0}; // of m_vbo, in vertices
+};
+
+#endif // LINEBATCH_H
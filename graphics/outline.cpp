@@ -1,64 +0,0 @@
-#include "outline.h"
-#include "maths/geometry.h"
-#include "utils/resourcemanager.h"
-
-#include <glad/glad.h>
-#include <glm/mat4x4.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-namespace Outline
-{
-constexpr GLfloat vertices[] = {
-    -0.5, -0.5, -0.5,
-     0.5, -0.5, -0.5,
-     0.5,  0.5, -0.5,
-    -0.5,  0.5, -0.5,
-    -0.5, -0.5,  0.5,
-     0.5, -0.5,  0.5,
-     0.5,  0.5,  0.5,
-    -0.5,  0.5,  0.5
-};
-
-constexpr GLushort elements[] = {
-    0, 1, 2, 3,
-    4, 5, 6, 7,
-    0, 4, 1, 5, 2, 6, 3, 7
-};
-
-void render(const Geom::AABB& box)
-{
-    unsigned int vao {0}, vbo {0}, ibo {0};
-
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof vertices, vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof elements, elements, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
-
-    glm::vec3 size {box.max - box.min};
-    glm::vec3 center {(box.max + box.min) * 0.5f};
-
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1), center) * glm::scale(glm::mat4(1), size);
-    auto& shader = ResourceManager::shaders().get("outline");
-    shader.use();
-    shader.setVec3("color", 0, 0, 0);
-    shader.setMat4("model", &modelMatrix[0][0]);
-
-    glLineWidth(2);
-    glDrawElements(GL_LINE_LOOP, 4, GL_UNSIGNED_SHORT, 0);
-    glDrawElements(GL_LINE_LOOP, 4, GL_UNSIGNED_SHORT, (GLvoid*)(4 * sizeof(GLushort)));
-    glDrawElements(GL_LINES, 8, GL_UNSIGNED_SHORT, (GLvoid*)(8 * sizeof(GLushort)));
-
-    glBindVertexArray(0);
-    glDeleteBuffers(1, &vbo);
-    glDeleteBuffers(1, &ibo);
-    glDeleteVertexArrays(1, &vao);
-}
-
-}
-
@@ -0,0 +1,101 @@
+#include "pngwriter.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    static const std::array<uint32_t, 256> table = []
+    {
+        std::array<uint32_t, 256> t;
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+void writeChunk(std::ofstream& out, const char* type, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> chunk;
+    putU32(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    // the crc covers type and data, not the length
+    putU32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    out.write((const char*)chunk.data(), chunk.size());
+}
+}
+
+bool PngWriter::write(const std::string& file, int width, int height, const uint8_t* rgba)
+{
+    std::ofstream out(file, std::ios::binary);
+    if (!out)
+        return false;
+
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.write((const char*)signature, sizeof signature);
+
+    std::vector<uint8_t> header;
+    putU32(header, width);
+    putU32(header, height);
+    header.insert(header.end(), {8, 6, 0, 0, 0}); // 8 bits, RGBA, deflate, no filter, no interlace
+    writeChunk(out, "IHDR", header);
+
+    // scanlines with filter type 0 in front
+    size_t rowSize = width * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba + y * rowSize, rgba + (y + 1) * rowSize);
+    }
+
+    // zlib stream of stored blocks, at most 65535 bytes each
+    std::vector<uint8_t> zlib {0x78, 0x01};
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    size_t pos = 0;
+    do
+    {
+        size_t len = std::min<size_t>(65535, raw.size() - pos);
+        bool last = pos + len == raw.size();
+        zlib.insert(zlib.end(), {(uint8_t)last, (uint8_t)len, (uint8_t)(len >> 8),
+                                 (uint8_t)~len, (uint8_t)(~len >> 8)});
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+    } while (pos < raw.size());
+
+    uint32_t a = 1, b = 0; // adler32
+    for (uint8_t byte : raw)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    putU32(zlib, (b << 16) | a);
+    writeChunk(out, "IDAT", zlib);
+    writeChunk(out, "IEND", {});
+
+    return (bool)out;
+}
@@ -0,0 +1,22 @@
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <cstdint>
+#include <string>
+
+/*
+    Minimal PNG encoder for frame captures: 8-bit RGBA, no row filters and
+    stored (uncompressed) deflate blocks. Files come out large, but it needs
+    no zlib.
+*/
+class PngWriter
+{
+public:
+    // rows top to bottom, 4 bytes per pixel
+    static bool write(const std::string& file, int width, int height, const uint8_t* rgba);
+
+private:
+    PngWriter() = default;
+};
+
+#endif // PNGWRITER_H
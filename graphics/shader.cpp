@@ -1,24 +1,125 @@
 #include "shader.h"
+#include "glstate.h"
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <filesystem>
+#include <vector>
 #include "utils/utils.h"
+#include "utils/drawcalltrack.h"
 
+namespace
+{
+// GL 4.1 / ARB_get_program_binary, not part of the 3.3 glad loader
+constexpr GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+constexpr GLenum PROGRAM_BINARY_LENGTH           = 0x8741;
+constexpr GLenum NUM_PROGRAM_BINARY_FORMATS      = 0x87FE;
+
+using GetProgramBinaryProc   = void (APIENTRYP)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+using ProgramBinaryProc      = void (APIENTRYP)(GLuint, GLenum, const void*, GLsizei);
+using ProgramParameteriProc  = void (APIENTRYP)(GLuint, GLenum, GLint);
+
+struct BinaryCache
+{
+    GetProgramBinaryProc    getProgramBinary {nullptr};
+    ProgramBinaryProc       programBinary {nullptr};
+    ProgramParameteriProc   programParameteri {nullptr};
+    std::string             driver;
+    std::string             dir {"shader_cache"};
+
+    bool enabled() const { return programBinary != nullptr; }
+} binaryCache;
+
+constexpr char BinaryMagic[4] = {'V', 'X', 'P', 'B'};
+
+// FNV-1a
+uint64_t hashText(uint64_t hash, const std::string& text)
+{
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+}
+
+void Shader::initBinaryCache(GLADloadproc load)
+{
+    bool supported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+    if (!supported)
+    {
+        int count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (int i = 0; i < count && !supported; i++)
+            supported = std::string((const char*)glGetStringi(GL_EXTENSIONS, i)) == "GL_ARB_get_program_binary";
+    }
+    int formats = 0;
+    if (supported)
+        glGetIntegerv(NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats == 0)
+    {
+        std::cout << "Program binaries are not supported, shaders are compiled on every start" << std::endl;
+        return;
+    }
+
+    binaryCache.getProgramBinary = (GetProgramBinaryProc) load("glGetProgramBinary");
+    binaryCache.programBinary = (ProgramBinaryProc) load("glProgramBinary");
+    binaryCache.programParameteri = (ProgramParameteriProc) load("glProgramParameteri");
+    if (!binaryCache.getProgramBinary || !binaryCache.programParameteri)
+        binaryCache.programBinary = nullptr;
 
-Shader::Shader(char const* vertexFilename, char const* fragmentFilename)
+    binaryCache.driver = std::string((const char*)glGetString(GL_VENDOR)) + '|' +
+                         (const char*)glGetString(GL_RENDERER) + '|' +
+                         (const char*)glGetString(GL_VERSION);
+}
+
+
+static void insertDefines(std::string& text, const std::string& defines)
 {
-    load(vertexFilename, fragmentFilename);
+    if (defines.empty())
+        return;
+    auto versionEnd = text.find('\n');
+    text.insert(versionEnd == std::string::npos ? text.size() : versionEnd + 1, defines);
 }
 
-void Shader::load(char const* vertexFilename, char const* fragmentFilename)
+Shader::Shader(char const* vertexFilename, char const* fragmentFilename, const std::string& defines)
+{
+    load(vertexFilename, fragmentFilename, defines);
+}
+
+void Shader::load(char const* vertexFilename, char const* fragmentFilename, const std::string& defines)
+{
+    loadFromSource(Utils::getTextFromFile(vertexFilename), Utils::getTextFromFile(fragmentFilename), defines);
+}
+
+void Shader::loadFromSource(std::string vsText, std::string fsText, const std::string& defines)
 {
     if (m_id != 0)
         cleanUp();
 
-    std::string vsText, fsText;
+    insertDefines(vsText, defines);
+    insertDefines(fsText, defines);
 
-    vsText = Utils::getTextFromFile(vertexFilename);
-    fsText = Utils::getTextFromFile(fragmentFilename);
+    std::string cacheFile;
+    if (binaryCache.enabled())
+    {
+        uint64_t hash = 14695981039346656037ull;
+        hash = hashText(hash, binaryCache.driver);
+        hash = hashText(hash, vsText);
+        hash = hashText(hash, fsText);
+        std::ostringstream name;
+        name << binaryCache.dir << '/' << std::hex << hash << ".bin";
+        cacheFile = name.str();
+
+        if (loadBinary(cacheFile))
+        {
+            readUniforms();
+            return;
+        }
+    }
 
     char const * vsTextPtr = vsText.c_str();
     char const * fsTextPtr = fsText.c_str();
@@ -40,11 +141,132 @@ void Shader::load(char const* vertexFilename, char const* fragmentFilename)
     glAttachShader(m_id, vertex_id);
     glAttachShader(m_id, fragment_id);
 
+    if (binaryCache.enabled())
+        binaryCache.programParameteri(m_id, PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(m_id);
     checkShaderProgramStatus(m_id);
 
     glDeleteShader(vertex_id);
     glDeleteShader(fragment_id);
+
+    readUniforms();
+    if (!cacheFile.empty())
+        saveBinary(cacheFile);
+}
+
+// A binary that the driver rejects (e.g. after an update that kept the version
+// string) is simply compiled again and overwritten
+bool Shader::loadBinary(const std::string& file)
+{
+    std::ifstream ifs(file, std::ios::binary);
+    if (!ifs)
+        return false;
+
+    char magic[4];
+    GLenum format;
+    GLint length;
+    ifs.read(magic, 4);
+    ifs.read((char*)&format, sizeof(format));
+    ifs.read((char*)&length, sizeof(length));
+    if (!ifs || !std::equal(magic, magic + 4, BinaryMagic) || length <= 0)
+        return false;
+
+    std::vector<char> binary(length);
+    if (!ifs.read(binary.data(), length))
+        return false;
+
+    m_id = glCreateProgram();
+    binaryCache.programBinary(m_id, format, binary.data(), length);
+
+    int success;
+    glGetProgramiv(m_id, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(m_id);
+        m_id = 0;
+        return false;
+    }
+    return true;
+}
+
+void Shader::saveBinary(const std::string& file)
+{
+    GLint length = 0;
+    glGetProgramiv(m_id, PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format;
+    binaryCache.getProgramBinary(m_id, length, nullptr, &format, binary.data());
+
+    std::error_code ec;
+    std::filesystem::create_directories(binaryCache.dir, ec);
+    std::ofstream ofs(file, std::ios::binary);
+    if (!ofs)
+        return;
+    ofs.write(BinaryMagic, 4);
+    ofs.write((const char*)&format, sizeof(format));
+    ofs.write((const char*)&length, sizeof(length));
+    ofs.write(binary.data(), length);
+}
+
+void Shader::readUniforms()
+{
+    m_uniforms.clear();
+
+    int count = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+    for (int i = 0; i < count; i++)
+    {
+        char name[128];
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(m_id, i, sizeof(name), &length, &size, &type, name);
+
+        Uniform uniform;
+        uniform.name.assign(name, length);
+        // arrays are reported as "name[0]", only their first element is tracked
+        auto bracket = uniform.name.find('[');
+        if (bracket != std::string::npos)
+            uniform.name.resize(bracket);
+        uniform.type = type;
+        uniform.location = glGetUniformLocation(m_id, name);
+        m_uniforms.emplace_back(std::move(uniform));
+    }
+}
+
+int Shader::find(const char* name) const
+{
+    // a handful of uniforms per program, a scan beats hashing
+    for (size_t i = 0; i < m_uniforms.size(); i++)
+        if (m_uniforms[i].name == name)
+            return i;
+    return -1;
+}
+
+void Shader::write(int index, const void* data, size_t size)
+{
+    Uniform& u = m_uniforms[index];
+    bool redundant = u.known && memcmp(u.value, data, size) == 0;
+    DrawCallTrack::countUniformSet(redundant);
+    if (redundant)
+        return;
+    memcpy(u.value, data, size);
+    u.known = true;
+
+    // glUniform* works on the bound program
+    const GLint* i = (const GLint*)u.value;
+    const GLfloat* f = u.value;
+    switch (u.type)
+    {
+    case GL_FLOAT:      glUniform1fv(u.location, 1, f); break;
+    case GL_FLOAT_VEC3: glUniform3fv(u.location, 1, f); break;
+    case GL_FLOAT_VEC4: glUniform4fv(u.location, 1, f); break;
+    case GL_FLOAT_MAT4: glUniformMatrix4fv(u.location, 1, GL_FALSE, f); break;
+    default:            glUniform1iv(u.location, 1, i); break;
+    }
 }
 
 Shader::~Shader()
@@ -54,12 +276,12 @@ Shader::~Shader()
 
 void Shader::cleanUp()
 {
-    glDeleteProgram(m_id);
+    GLState::deleteProgram(m_id);
 }
 
 void Shader::use() const
 {
-    glUseProgram(m_id);
+    GLState::useProgram(m_id);
 }
 
 unsigned int Shader::id() const
@@ -95,38 +317,39 @@ void Shader::checkShaderProgramStatus(unsigned int id)
     }
 }
 
-void Shader::setInt(const std::string& name, const int value)
+void Shader::setInt(const char* name, const int value)
 {
-    glUniform1i(glGetUniformLocation(m_id, name.c_str()), value);
+    set(uniform<int>(name), value);
 }
 
-void Shader::setFloat(const std::string& name, const float value)
+void Shader::setFloat(const char* name, const float value)
 {
-    glUniform1f(glGetUniformLocation(m_id, name.c_str()), value);
+    set(uniform<float>(name), value);
 }
 
-void Shader::setMat4(const std::string& name, const float* m)
+void Shader::setMat4(const char* name, const float* m)
 {
-    glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, m);
+    int index = find(name);
+    if (index >= 0 && m_uniforms[index].type == GL_FLOAT_MAT4)
+        write(index, m, 16 * sizeof(float));
 }
 
-void Shader::setVec3(const std::string& name, const float* v)
+void Shader::setVec3(const char* name, const float* v)
 {
-    glUniform3fv(glGetUniformLocation(m_id, name.c_str()), 1, v);
+    set(uniform<glm::vec3>(name), glm::vec3(v[0], v[1], v[2]));
 }
 
-void Shader::setVec4(const std::string& name, const float* v)
+void Shader::setVec4(const char* name, const float* v)
 {
-    glUniform4fv(glGetUniformLocation(m_id, name.c_str()), 1, v);
+    set(uniform<glm::vec4>(name), glm::vec4(v[0], v[1], v[2], v[3]));
 }
 
-void Shader::setVec3(const std::string& name, float x, float y, float z)
+void Shader::setVec3(const char* name, float x, float y, float z)
 {
-    glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+    set(uniform<glm::vec3>(name), glm::vec3(x, y, z));
 }
 
-void Shader::setVec4(const std::string& name, float x, float y, float z, float w)
+void Shader::setVec4(const char* name, float x, float y, float z, float w)
 {
-    glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+    set(uniform<glm::vec4>(name), glm::vec4(x, y, z, w));
 }
-
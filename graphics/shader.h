@@ -3,35 +3,109 @@
 
 #include "glad/glad.h"
 #include <string>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 #include "utils/noncopyable.h"
 
+// GL types of the uniforms a value of type T can be written to
+template <typename T> struct UniformType;
+template <> struct UniformType<int>
+{
+    static bool accepts(GLenum t) { return t == GL_INT || t == GL_BOOL || t == GL_SAMPLER_2D ||
+                                           t == GL_SAMPLER_2D_ARRAY || t == GL_SAMPLER_CUBE; }
+};
+template <> struct UniformType<float>     { static bool accepts(GLenum t) { return t == GL_FLOAT; } };
+template <> struct UniformType<glm::vec3> { static bool accepts(GLenum t) { return t == GL_FLOAT_VEC3; } };
+template <> struct UniformType<glm::vec4> { static bool accepts(GLenum t) { return t == GL_FLOAT_VEC4; } };
+template <> struct UniformType<glm::mat4> { static bool accepts(GLenum t) { return t == GL_FLOAT_MAT4; } };
+
+// Index into the uniform table of one Shader. Default constructed or looked up with a
+// wrong name or type it is invalid, and setting it does nothing
+template <typename T>
+class UniformLocation
+{
+public:
+    UniformLocation() = default;
+    bool valid() const {return m_index >= 0;}
+
+private:
+    friend class Shader;
+    explicit UniformLocation(int index) : m_index(index) {}
+    int m_index {-1};
+};
+
 class Shader : NonCopyable
 {
 public:
     Shader() = default;
-    Shader(char const * vertexFilename, char const * fragmentFilename);
+    Shader(char const * vertexFilename, char const * fragmentFilename, const std::string& defines = "");
     ~Shader();
 
-    void load(char const * vertexFilename, char const * fragmentFilename);
+    // defines, e.g. "#define FOO\n", are inserted after the #version line of both sources
+    void load(char const * vertexFilename, char const * fragmentFilename, const std::string& defines = "");
+    void loadFromSource(std::string vertexSource, std::string fragmentSource, const std::string& defines = "");
     void use() const;
     unsigned int id() const;
 
-    void setInt  (const std::string& name, const int value);
-    void setFloat(const std::string& name, const float value);
-    void setMat4(const std::string& name, const float* m);
-    void setVec3(const std::string& name, const float* v);
-    void setVec3(const std::string& name, float x, float y, float z);
-    void setVec4(const std::string& name, const float* v);
-    void setVec4(const std::string& name, float x, float y, float z, float w);
+    // Linked programs are stored in shader_cache/ and loaded from there when the
+    // sources and the driver match. Needs GL 4.1 or ARB_get_program_binary, which
+    // glad 3.3 doesn't load, hence the proc loader
+    static void initBinaryCache(GLADloadproc load);
+
+    // The active uniforms are read into a table at link time. Look a handle up once,
+    // then set() costs a compare with the last value and, if it changed, the GL call.
+    // Setting the value a uniform already has is skipped and counted by DrawCallTrack
+    template <typename T>
+    UniformLocation<T> uniform(const char* name) const
+    {
+        int index = find(name);
+        if (index < 0 || !UniformType<T>::accepts(m_uniforms[index].type))
+            return UniformLocation<T>();
+        return UniformLocation<T>(index);
+    }
+
+    template <typename T>
+    void set(UniformLocation<T> uniform, const T& value)
+    {
+        if (uniform.valid())
+            write(uniform.m_index, &value, sizeof(T));
+    }
+
+    // by name, for setup code and per-frame values
+    void setInt  (const char* name, const int value);
+    void setFloat(const char* name, const float value);
+    void setMat4(const char* name, const float* m);
+    void setVec3(const char* name, const float* v);
+    void setVec3(const char* name, float x, float y, float z);
+    void setVec4(const char* name, const float* v);
+    void setVec4(const char* name, float x, float y, float z, float w);
 
 private:
+    struct Uniform
+    {
+        std::string     name;
+        GLenum          type;
+        int             location;
+        bool            known {false};  // value below was set since the link
+        float           value[16];      // big enough for a mat4, ints are stored bitwise
+    };
+
+    int  find(const char* name) const;
+    void write(int index, const void* data, size_t size);
+
+    bool loadBinary(const std::string& file);
+    void saveBinary(const std::string& file);
+    void readUniforms();
     void cleanUp();
     void checkShaderStatus(unsigned int id);
     void checkShaderProgramStatus(unsigned int id);
 
 private:
     unsigned int m_id {0};
+    std::vector<Uniform> m_uniforms;
 };
 
 #endif // SHADER_H_INCLUDED
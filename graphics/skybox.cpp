@@ -1,4 +1,5 @@
 #include "skybox.h"
+#include "glstate.h"
 #include "utils/drawcalltrack.h"
 
 static constexpr float skyboxVertices[] =
@@ -50,8 +51,8 @@ static constexpr float skyboxVertices[] =
 
 Skybox::~Skybox()
 {
-    glDeleteBuffers(1, &m_vbo);
-    glDeleteVertexArrays(1, &m_vao);
+    GLState::deleteBuffer(m_vbo);
+    GLState::deleteVertexArray(m_vao);
 }
 
 void Skybox::initialize()
@@ -59,13 +60,13 @@ void Skybox::initialize()
     if (m_vao == 0)
     {
         glGenVertexArrays(1, &m_vao);
-        glBindVertexArray(m_vao);
+        GLState::bindVertexArray(m_vao);
         glGenBuffers(1, &m_vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
         glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
         glEnableVertexAttribArray(0);
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
     }
 }
 
@@ -78,12 +79,12 @@ void Skybox::setTransform(const glm::mat4& transform)
 void Skybox::render()
 {
     m_shader->use();
-    glDepthFunc(GL_LEQUAL);
+    GLState::depthFunc(GL_LEQUAL);
 
-    glBindVertexArray(m_vao);
+    GLState::bindVertexArray(m_vao);
     m_texture->bind();
     glDrawArrays_(GL_TRIANGLES, 0, 36);
 
-    glDepthFunc(GL_LESS);
+    GLState::depthFunc(GL_LESS);
 }
 
@@ -1,17 +1,17 @@
 #include "texture.h"
+#include "glstate.h"
 #include <glad/glad.h>
 
 Texture::~Texture()
 {
-    glDeleteTextures(1, &m_id);
+    GLState::deleteTexture(m_id);
 }
 
 void Texture::bind() const
 {
     if (m_id)
     {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(m_target, m_id);
+        GLState::bindTexture(0, m_target, m_id);
     }
 }
 
@@ -1,55 +1,143 @@
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include <glad/glad.h>
 #include "3rdparty/stb_image.h"
 #include "textureloader.h"
+#include "glstate.h"
 
-TexturePtr TextureLoader::loadTexture(const std::string& path, bool flipVertically)
+// stb's flip flag is global, so images are always decoded as stored and flipped here
+Image TextureLoader::decode(const std::string& path, int channels, bool flipVertically)
 {
-    GLuint id = 0;
-    int w, h, ch;
-
-    stbi_set_flip_vertically_on_load(flipVertically ? 1 : 0);
-    unsigned char* data = stbi_load(path.c_str(), &w, &h, &ch, 4);
+    Image image;
+    int ch;
+    unsigned char* data = stbi_load(path.c_str(), &image.width, &image.height, &ch, channels);
     if (!data)
     {
         std::cerr << "stbi_load failed for " << path << std::endl;
+        image.width = image.height = 0;
+        return image;
     }
+    image.channels = channels;
+    size_t rowSize = image.width * channels;
+    image.pixels.resize(rowSize * image.height);
+    for (int y = 0; y < image.height; y++)
+    {
+        int src = flipVertically ? image.height - 1 - y : y;
+        std::memcpy(&image.pixels[y * rowSize], data + src * rowSize, rowSize);
+    }
+    stbi_image_free(data);
+    return image;
+}
+
+TexturePtr TextureLoader::loadTexture(const std::string& path, bool flipVertically)
+{
+    return createTexture(decode(path, 4, flipVertically));
+}
+
+TexturePtr TextureLoader::loadTextureArray(const std::string& path, bool flipVertically)
+{
+    return createTextureArray(decode(path, 4, flipVertically));
+}
+
+TexturePtr TextureLoader::loadCubeMap(const std::array<std::string, 6>& paths, bool flipVertically)
+{
+    std::array<Image, 6> faces;
+    for (int i = 0; i < 6; i++)
+        faces[i] = decode(paths[i], 3, flipVertically);
+    return createCubeMap(faces);
+}
+
+TexturePtr TextureLoader::createTexture(const Image& image)
+{
+    GLuint id = 0;
     glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    GLState::bindTexture(0, GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 image.pixels.empty() ? nullptr : image.pixels.data());
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    stbi_image_free(data);
-
     return makeTexture(GL_TEXTURE_2D, id);
 }
 
-TexturePtr TextureLoader::loadCubeMap(const std::array<std::string, 6>& paths, bool flipVertically)
+// EXT_texture_filter_anisotropic, not in the generated loader
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT       0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT   0x84FF
+#endif
+
+static bool hasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        auto ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (ext && std::strcmp(ext, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+TexturePtr TextureLoader::createTextureArray(const Image& image)
 {
     GLuint id = 0;
-    int w, h, ch;
-    unsigned char* data = nullptr;
+    if (image.pixels.empty())
+        return makeTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    int w = image.width, tile = image.height, tiles = w / tile;
+    const unsigned char* data = image.pixels.data();
 
     glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, id);
+    // layer 0 is Blocks::Type::None, so that block types index layers directly
+    std::vector<unsigned char> empty(tile * tile * 4, 0);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, tile, tile, tiles + 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, tile, tile, 1, GL_RGBA, GL_UNSIGNED_BYTE, empty.data());
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
+    for (int t = 0; t < tiles; t++)
+    {
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, t * tile);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, t + 1, tile, tile, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    if (hasExtension("GL_EXT_texture_filter_anisotropic") ||
+        hasExtension("GL_ARB_texture_filter_anisotropic"))
+    {
+        float maxAnisotropy = 1;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(maxAnisotropy, 8.0f));
+    }
 
-    stbi_set_flip_vertically_on_load(flipVertically ? 1 : 0);
+    return makeTexture(GL_TEXTURE_2D_ARRAY, id);
+}
+
+TexturePtr TextureLoader::createCubeMap(const std::array<Image, 6>& faces)
+{
+    GLuint id = 0;
+
+    glGenTextures(1, &id);
+    GLState::bindTexture(0, GL_TEXTURE_CUBE_MAP, id);
 
     for (int i = 0; i < 6; i++)
     {
-        auto path = paths[i].c_str();
-        data = stbi_load(path, &w, &h, &ch, 3);
-        if (!data)
-        {
-            std::cerr << "stbi_load failed for " << path << std::endl;
-        }
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, w, h, 0,
-                     GL_RGB, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
+        const Image& face = faces[i];
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, face.width, face.height, 0,
+                     GL_RGB, GL_UNSIGNED_BYTE, face.pixels.empty() ? nullptr : face.pixels.data());
     }
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
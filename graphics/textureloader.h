@@ -4,17 +4,33 @@
 #include <string>
 #include <array>
 #include <memory>
+#include <vector>
 
 #include "texture.h"
 
 using TexturePtr = std::unique_ptr<Texture>;
 
+// decoded pixels, rows bottom-up when flipped
+struct Image
+{
+    int width {0}, height {0}, channels {0};
+    std::vector<unsigned char> pixels;
+};
+
 class TextureLoader
 {
 public:
     static TexturePtr loadTexture(const std::string& path, bool flipVertically = true);
+    // image made of square tiles in a row, tile i becomes layer i + 1 of a mipmapped array texture
+    static TexturePtr loadTextureArray(const std::string& path, bool flipVertically = true);
     static TexturePtr loadCubeMap(const std::array<std::string, 6>& paths, bool flipVertically = true);
 
+    // decoding is thread safe, creating textures needs the GL thread
+    static Image      decode(const std::string& path, int channels, bool flipVertically = true);
+    static TexturePtr createTexture(const Image& image);
+    static TexturePtr createTextureArray(const Image& image);
+    static TexturePtr createCubeMap(const std::array<Image, 6>& faces);
+
 private:
     TextureLoader() = default;
 
@@ -0,0 +1,99 @@
+#include "headlesscontext.h"
+#include <stdexcept>
+#include <string>
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace
+{
+bool hasExtension(const char* extensions, const std::string& name)
+{
+    return extensions && (" " + std::string(extensions) + " ").find(" " + name + " ") != std::string::npos;
+}
+
+EGLDisplay getDisplay()
+{
+    // surfaceless needs neither X nor a GPU; llvmpipe renders there as well
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+}
+
+HeadlessContext::HeadlessContext()
+{
+    EGLDisplay display = getDisplay();
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        throw std::runtime_error("eglInitialize failed");
+    m_display = display;
+
+    if (!hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+        throw std::runtime_error("EGL_KHR_surfaceless_context is not supported");
+    if (!eglBindAPI(EGL_OPENGL_API))
+        throw std::runtime_error("eglBindAPI(EGL_OPENGL_API) failed");
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE,       EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE,    EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0)
+        throw std::runtime_error("eglChooseConfig found no OpenGL config");
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION,          3,
+        EGL_CONTEXT_MINOR_VERSION,          3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT)
+        throw std::runtime_error("eglCreateContext failed");
+    m_context = context;
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        throw std::runtime_error("eglMakeCurrent failed");
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    if (m_context)
+    {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(m_display, m_context);
+    }
+    if (m_display)
+        eglTerminate(m_display);
+}
+
+void* HeadlessContext::getProcAddress(const char* name)
+{
+    return (void*)eglGetProcAddress(name);
+}
+
+#else
+
+HeadlessContext::HeadlessContext()
+{
+    throw std::runtime_error("headless mode needs a build with EGL");
+}
+
+HeadlessContext::~HeadlessContext()
+{
+}
+
+void* HeadlessContext::getProcAddress(const char* /*name*/)
+{
+    return nullptr;
+}
+
+#endif
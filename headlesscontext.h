@@ -0,0 +1,25 @@
+#ifndef HEADLESSCONTEXT_H
+#define HEADLESSCONTEXT_H
+
+#include "utils/noncopyable.h"
+
+/*
+    GL 3.3 core context without a window or display, through EGL on Mesa's
+    surfaceless platform (or the default display). There is no default
+    framebuffer, rendering has to go into an FBO. Needs a build with EGL.
+*/
+class HeadlessContext : public NonCopyable
+{
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    // for gladLoadGLLoader
+    static void* getProcAddress(const char* name);
+
+private:
+    void*   m_display {nullptr};
+    void*   m_context {nullptr};
+};
+
+#endif // HEADLESSCONTEXT_H
@@ -1,22 +1,75 @@
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
 #include "application.h"
+#include "benchmark.h"
 #include "glfwcontext.h"
+#include "headlesscontext.h"
 #include "settings.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark [script]     scripted flythrough, see benchmark.h
+    // --headless               no window, needs an EGL build
+    // --capture <s>[,<s>...]   save the frames at these run times to PNG, headless only
+    std::unique_ptr<Benchmark> benchmark;
+    RunOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--benchmark")
+        {
+            std::string script = "benchmark.txt";
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                script = argv[++i];
+            benchmark = std::make_unique<Benchmark>();
+            if (!benchmark->loadScript(script))
+                return 1;
+            options.benchmark = benchmark.get();
+        }
+        else if (arg == "--headless")
+            options.headless = true;
+        else if (arg == "--capture" && i + 1 < argc)
+        {
+            std::stringstream times {argv[++i]};
+            std::string time;
+            while (std::getline(times, time, ','))
+            {
+                try {
+                    options.captures.push_back(std::stof(time));
+                }
+                catch (std::exception&) {
+                    std::cerr << "Bad capture time: " << time << std::endl;
+                    return 1;
+                }
+            }
+        }
+        else
+            std::cerr << "Unknown argument: " << arg << std::endl;
+    }
+    if (!options.captures.empty() && !options.headless)
+        std::cerr << "--capture works with --headless only, ignored" << std::endl;
+
     try {
-        GlfwContext glfwCtx{"Voxel world",
-                            Settings::get().rendering().width,
-                            Settings::get().rendering().height};
+        std::unique_ptr<GlfwContext> glfwCtx;
+        std::unique_ptr<HeadlessContext> headlessCtx;
+        if (options.headless)
+            headlessCtx = std::make_unique<HeadlessContext>();
+        else
+            glfwCtx = std::make_unique<GlfwContext>("Voxel world",
+                                                    Settings::get().rendering().width,
+                                                    Settings::get().rendering().height);
 
-        Application{glfwCtx.getWindow()}.run();
+        Application{glfwCtx ? glfwCtx->getWindow() : nullptr, options}.run();
     }
     catch(std::exception& ex) {
         std::cerr << ex.what();
+        return 1;
     }
     catch(...) {
         std::cerr << "Unknown exception\n";
+        return 1;
     }
     return 0;
 }
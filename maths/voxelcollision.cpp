@@ -0,0 +1,78 @@
+#include "voxelcollision.h"
+#include "blockregion.h"
+#include "chunk.h"
+
+#include <cmath>
+#include <algorithm>
+
+constexpr float Eps = 1e-4f;
+constexpr float Skin = 1e-3f; // distance kept between the box and a block it's stopped by
+
+namespace Collision
+{
+
+static bool isSlabSolid(const BlockRegion& region, int axis, int cell, int lo[3], int hi[3])
+{
+    int from[3] = {lo[0], lo[1], lo[2]};
+    int to[3]   = {hi[0], hi[1], hi[2]};
+    from[axis] = to[axis] = cell;
+
+    for (int x = from[0]; x <= to[0]; x++)
+    for (int y = from[1]; y <= to[1]; y++)
+    for (int z = from[2]; z <= to[2]; z++)
+        if (Blocks::isSolid(region.get(x, y, z)))
+            return true;
+    return false;
+}
+
+// how far the box can move along one axis before it hits a solid block
+static float sweepAxis(const Geom::AABB& box, int axis, float delta, const BlockRegion& region)
+{
+    if (delta == 0)
+        return 0;
+
+    // cells the box overlaps on all axes
+    int lo[3], hi[3];
+    for (int i = 0; i < 3; i++)
+    {
+        lo[i] = (int)std::floor(box.min[i] + Eps);
+        hi[i] = (int)std::ceil(box.max[i] - Eps) - 1;
+    }
+
+    if (delta > 0)
+    {
+        int first = hi[axis] + 1;
+        int last = (int)std::ceil(box.max[axis] + delta) - 1;
+        for (int c = first; c <= last; c++)
+            if (isSlabSolid(region, axis, c, lo, hi))
+                return std::max(0.0f, c - box.max[axis] - Skin);
+    }
+    else
+    {
+        int first = lo[axis] - 1;
+        int last = (int)std::floor(box.min[axis] + delta);
+        for (int c = first; c >= last; c--)
+            if (isSlabSolid(region, axis, c, lo, hi))
+                return std::min(0.0f, c + 1 - box.min[axis] + Skin);
+    }
+    return delta;
+}
+
+glm::vec3 sweepAABB(const Geom::AABB& box, const glm::vec3& velocity,
+                    const BlockRegion& region, bool blocked[3])
+{
+    Geom::AABB moved = box;
+    glm::vec3 result {0, 0, 0};
+
+    for (int axis : {0, 2, 1})
+    {
+        float d = sweepAxis(moved, axis, velocity[axis], region);
+        blocked[axis] = d != velocity[axis];
+        moved.min[axis] += d;
+        moved.max[axis] += d;
+        result[axis] = d;
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,20 @@
+#ifndef VOXELCOLLISION_H
+#define VOXELCOLLISION_H
+
+#include <glm/vec3.hpp>
+#include "geometry.h"
+
+struct BlockRegion;
+
+namespace Collision
+{
+
+// Moves the box by velocity one axis at a time (x, z, then y), stopping it in front of
+// solid blocks. The region must cover the box swept by velocity. Returns the movement
+// actually made; blocked[i] is set if movement along axis i was cut short.
+glm::vec3 sweepAABB(const Geom::AABB& box, const glm::vec3& velocity,
+                    const BlockRegion& region, bool blocked[3]);
+
+}
+
+#endif // VOXELCOLLISION_H
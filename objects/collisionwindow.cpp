@@ -0,0 +1,126 @@
+#include "collisionwindow.h"
+#include "chunkmanager.h"
+
+#include <cmath>
+
+constexpr int Margin = 2; // extra blocks fetched around the body, so it can move a bit before a refetch
+
+// neighbour offsets in the order of faces in AABB::getTriangles
+constexpr int FaceDir[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+static bool overlaps(const Position3& min1, const Position3& max1,
+                     const Position3& min2, const Position3& max2)
+{
+    return min1.x <= max2.x && min2.x <= max1.x &&
+           min1.y <= max2.y && min2.y <= max1.y &&
+           min1.z <= max2.z && min2.z <= max1.z;
+}
+
+void CollisionWindow::update(const ChunkManager& world, const Geom::AABB& box)
+{
+    // blocks the box touches, plus one around for sweeps and neighbour checks
+    Position3 needMin {(int)std::floor(box.min.x) - 1, (int)std::floor(box.min.y) - 1, (int)std::floor(box.min.z) - 1};
+    Position3 needMax {(int)std::floor(box.max.x) + 1, (int)std::floor(box.max.y) + 1, (int)std::floor(box.max.z) + 1};
+
+    const Position3& o = m_region.origin;
+    const Position3& s = m_region.size;
+
+    if (!m_valid ||
+        needMin.x < o.x || needMax.x >= o.x + s.x ||
+        needMin.y < o.y || needMax.y >= o.y + s.y ||
+        needMin.z < o.z || needMax.z >= o.z + s.z)
+    {
+        refetch(world, {needMin.x - Margin, needMin.y - Margin, needMin.z - Margin},
+                       {needMax.x + Margin, needMax.y + Margin, needMax.z + Margin});
+        return;
+    }
+
+    Position3 winMax {o.x + s.x - 1, o.y + s.y - 1, o.z + s.z - 1};
+    WorldChange change;
+
+    for (; m_changeCount != world.getChangeCount(); m_changeCount++)
+    {
+        if (!world.getChange(m_changeCount, change))
+        {   // fell too far behind the log
+            refetch(world, o, winMax);
+            return;
+        }
+        if (!overlaps(change.min, change.max, o, winMax))
+            continue;
+
+        if (!(change.min == change.max))
+        {   // a whole column was (un)loaded
+            refetch(world, o, winMax);
+            return;
+        }
+        const Position3& p = change.min;
+        m_region.blocks[m_region.index(p.x, p.y, p.z)] = change.type;
+
+        updateFaces(p.x, p.y, p.z);
+        for (const auto& d : FaceDir)
+            if (m_region.contains(p.x + d[0], p.y + d[1], p.z + d[2]))
+                updateFaces(p.x + d[0], p.y + d[1], p.z + d[2]);
+    }
+}
+
+void CollisionWindow::refetch(const ChunkManager& world, const Position3& min, const Position3& max)
+{
+    m_changeCount = world.getChangeCount();
+    world.getRegion(min, {max.x - min.x + 1, max.y - min.y + 1, max.z - min.z + 1}, m_region);
+    m_faces.assign(m_region.blocks.size(), 0);
+
+    for (int x = min.x; x <= max.x; x++)
+    for (int y = min.y; y <= max.y; y++)
+    for (int z = min.z; z <= max.z; z++)
+        updateFaces(x, y, z);
+
+    m_valid = true;
+}
+
+bool CollisionWindow::isSolid(int x, int y, int z) const
+{
+    // outside of the window counts as empty, so border blocks keep their outer faces
+    return Blocks::isSolid(m_region.get(x, y, z));
+}
+
+void CollisionWindow::updateFaces(int x, int y, int z)
+{
+    uint8_t mask = 0;
+    if (isSolid(x, y, z))
+    {
+        for (int f = 0; f < 6; f++)
+            if (!isSolid(x + FaceDir[f][0], y + FaceDir[f][1], z + FaceDir[f][2]))
+                mask |= 1 << f;
+    }
+    m_faces[m_region.index(x, y, z)] = mask;
+}
+
+void CollisionWindow::gatherTriangles(const Geom::AABB& box, const glm::vec3& scale,
+                                      std::vector<Geom::Triangle>& out) const
+{
+    int xmin = std::floor(box.min.x), xmax = std::floor(box.max.x);
+    int ymin = std::floor(box.min.y), ymax = std::floor(box.max.y);
+    int zmin = std::floor(box.min.z), zmax = std::floor(box.max.z);
+
+    for (int x = xmin; x <= xmax; x++)
+    for (int y = ymin; y <= ymax; y++)
+    for (int z = zmin; z <= zmax; z++)
+    {
+        if (!m_region.contains(x, y, z))
+            continue;
+        uint8_t mask = m_faces[m_region.index(x, y, z)];
+        if (!mask)
+            continue;
+
+        Geom::AABB blockBox({x, y, z}, {x + 1, y + 1, z + 1});
+        auto triangles = blockBox.getTriangles();
+
+        for (int f = 0; f < 6; f++)
+        {
+            if (!(mask & (1 << f)))
+                continue;
+            for (int t = 2 * f; t < 2 * f + 2; t++)
+                out.emplace_back(triangles[t].p1 / scale, triangles[t].p2 / scale, triangles[t].p3 / scale);
+        }
+    }
+}
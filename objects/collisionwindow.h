@@ -0,0 +1,42 @@
+#ifndef COLLISIONWINDOW_H
+#define COLLISIONWINDOW_H
+
+#include <vector>
+#include "blockregion.h"
+#include "maths/geometry.h"
+
+class ChunkManager;
+
+/*
+    Cached copy of the blocks around one moving body, plus a mask of exposed faces
+    (faces of solid blocks next to a non-solid one, the only ones a body can touch).
+    The window is refetched only when the body leaves it, and world edits are
+    patched in from ChunkManager's change log. Every body keeps its own window,
+    so collision cost doesn't depend on the world, only on what's around the body.
+    update() only reads the world, windows of different bodies can be updated in parallel.
+*/
+class CollisionWindow
+{
+public:
+    // makes the window cover box (world coordinates) and catches up with world changes
+    void update(const ChunkManager& world, const Geom::AABB& box);
+
+    const BlockRegion& region() const {return m_region;}
+
+    // appends triangles of exposed faces of blocks overlapping box, divided by scale
+    void gatherTriangles(const Geom::AABB& box, const glm::vec3& scale,
+                         std::vector<Geom::Triangle>& out) const;
+
+private:
+    void refetch(const ChunkManager& world, const Position3& min, const Position3& max);
+    void updateFaces(int x, int y, int z);
+    bool isSolid(int x, int y, int z) const;
+
+private:
+    BlockRegion             m_region;
+    std::vector<uint8_t>    m_faces;    // exposed face bits per block, same layout as m_region
+    unsigned                m_changeCount {0};
+    bool                    m_valid {false};
+};
+
+#endif // COLLISIONWINDOW_H
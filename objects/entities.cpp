@@ -0,0 +1,208 @@
+#include "entities.h"
+#include "chunkmanager.h"
+#include "graphics/glstate.h"
+#include "maths/voxelcollision.h"
+#include "utils/constants.h"
+#include "utils/drawcalltrack.h"
+#include "utils/profiler.h"
+#include "utils/threadpool.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+constexpr int   MaxEntities = 50000;
+constexpr float KillHeight = -32;   // entities falling out of the loaded world are removed
+constexpr float GroundFriction = 0.8f;
+constexpr int   InstanceFloats = 7; // center, half size, block type
+
+// Faces of the [-1, 1] cube: normal and two tangents with cross(u, v) == normal,
+// so that corners come out counter-clockwise when seen from outside
+constexpr float CubeFaces[6][3][3] = {
+    {{-1, 0, 0}, { 0, 0,  1}, {0, 1,  0}},
+    {{ 1, 0, 0}, { 0, 0, -1}, {0, 1,  0}},
+    {{ 0,-1, 0}, { 1, 0,  0}, {0, 0,  1}},
+    {{ 0, 1, 0}, { 1, 0,  0}, {0, 0, -1}},
+    {{ 0, 0,-1}, {-1, 0,  0}, {0, 1,  0}},
+    {{ 0, 0, 1}, { 1, 0,  0}, {0, 1,  0}},
+};
+
+EntityStore::~EntityStore()
+{
+    GLState::deleteBuffer(m_cubeVbo);
+    GLState::deleteBuffer(m_instanceVbo);
+    GLState::deleteVertexArray(m_vao);
+}
+
+void EntityStore::initialize()
+{
+    if (m_vao != 0)
+        return;
+
+    // position | texture coords, shading
+    std::vector<float> cube;
+    constexpr float corners[6][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, -1}, {1, 1}, {-1, 1}};
+
+    for (int f = 0; f < 6; f++)
+    {
+        auto& n = CubeFaces[f][0];
+        auto& u = CubeFaces[f][1];
+        auto& v = CubeFaces[f][2];
+        float shade = n[1] == 0 ? 0.6f : 1.0f; // same as vertical faces of chunks
+
+        for (auto& c : corners)
+        {
+            for (int i = 0; i < 3; i++)
+                cube.push_back(n[i] + c[0] * u[i] + c[1] * v[i]);
+            cube.push_back((c[0] + 1) / 2);
+            cube.push_back((c[1] + 1) / 2);
+            cube.push_back(shade);
+        }
+    }
+
+    glGenVertexArrays(1, &m_vao);
+    GLState::bindVertexArray(m_vao);
+
+    glGenBuffers(1, &m_cubeVbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_cubeVbo);
+    glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(float), cube.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    glGenBuffers(1, &m_instanceVbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+    constexpr int stride = InstanceFloats * sizeof(float);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+    for (int attr = 2; attr <= 4; attr++)
+    {
+        glEnableVertexAttribArray(attr);
+        glVertexAttribDivisor(attr, 1);
+    }
+    GLState::bindVertexArray(0);
+}
+
+void EntityStore::spawn(const glm::vec3& position, const glm::vec3& velocity,
+                        const glm::vec3& halfSize, uint8_t block)
+{
+    if (count() >= MaxEntities)
+        return;
+
+    m_position.push_back(position);
+    m_velocity.push_back(velocity);
+    m_halfSize.push_back(halfSize);
+    m_block.push_back(block);
+    m_onGround.push_back(0);
+    m_windows.emplace_back();
+}
+
+void EntityStore::clear()
+{
+    m_position.clear();
+    m_velocity.clear();
+    m_halfSize.clear();
+    m_block.clear();
+    m_onGround.clear();
+    m_windows.clear();
+}
+
+int EntityStore::count() const
+{
+    return m_position.size();
+}
+
+void EntityStore::remove(int i)
+{
+    // swap with the last one, order doesn't matter
+    m_position[i] = m_position.back();  m_position.pop_back();
+    m_velocity[i] = m_velocity.back();  m_velocity.pop_back();
+    m_halfSize[i] = m_halfSize.back();  m_halfSize.pop_back();
+    m_block[i] = m_block.back();        m_block.pop_back();
+    m_onGround[i] = m_onGround.back();  m_onGround.pop_back();
+    std::swap(m_windows[i], m_windows.back());
+    m_windows.pop_back();
+}
+
+void EntityStore::update(const ChunkManager& world, float dt)
+{
+    PROFILE_ZONE("EntityStore::update");
+    m_stepTimer.restart();
+
+    ThreadPool::get().parallelFor(count(), [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+            step(world, i, dt);
+    });
+
+    m_stepTimeMs = m_stepTimer.getElapsedSecs() * 1000;
+    m_steppedCount = count();
+
+    for (int i = count() - 1; i >= 0; i--)
+        if (m_position[i].y < KillHeight)
+            remove(i);
+}
+
+void EntityStore::step(const ChunkManager& world, int i, float dt)
+{
+    glm::vec3& velocity = m_velocity[i];
+    velocity.y -= Consts::GRAVITY * dt;
+
+    Geom::AABB box {m_position[i] - m_halfSize[i], m_position[i] + m_halfSize[i]};
+    m_windows[i].update(world, {glm::min(box.min, box.min + velocity),
+                                glm::max(box.max, box.max + velocity)});
+
+    bool blocked[3];
+    m_position[i] += Collision::sweepAABB(box, velocity, m_windows[i].region(), blocked);
+
+    m_onGround[i] = blocked[1] && velocity.y < 0;
+    for (int axis = 0; axis < 3; axis++)
+        if (blocked[axis])
+            velocity[axis] = 0;
+
+    if (m_onGround[i])
+    {
+        velocity.x *= GroundFriction;
+        velocity.z *= GroundFriction;
+    }
+}
+
+double EntityStore::getStepTimeMs() const
+{
+    return m_stepTimeMs;
+}
+
+double EntityStore::getEntitiesPerMs() const
+{
+    return m_stepTimeMs > 0 ? m_steppedCount / m_stepTimeMs : 0;
+}
+
+void EntityStore::setTransform(const glm::mat4& transform)
+{
+    m_shader->use();
+    m_shader->setMat4("proj_view", &transform[0][0]);
+}
+
+void EntityStore::render()
+{
+    PROFILE_ZONE("EntityStore::render");
+    if (m_position.empty())
+        return;
+
+    m_instanceData.clear();
+    for (int i = 0; i < count(); i++)
+    {
+        const glm::vec3& p = m_position[i];
+        const glm::vec3& h = m_halfSize[i];
+        m_instanceData.insert(m_instanceData.end(), {p.x, p.y, p.z, h.x, h.y, h.z, (float)m_block[i]});
+    }
+
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, m_instanceData.size() * sizeof(float), m_instanceData.data(), GL_STREAM_DRAW);
+
+    m_shader->use();
+    m_texture->bind();
+    GLState::bindVertexArray(m_vao);
+    glDrawArraysInstanced_(GL_TRIANGLES, 0, 36, count());
+}
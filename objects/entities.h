@@ -0,0 +1,65 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+#include "collisionwindow.h"
+#include "graphics/renderable.h"
+#include "utils/noncopyable.h"
+#include "utils/timer.h"
+
+class ChunkManager;
+
+/*
+    Simple moving bodies: falling blocks, items, mobs.
+    Stored as a struct of arrays, stepped in parallel against the block grid with
+    the same gravity as WalkingControl and drawn with a single instanced draw call.
+    Velocities are in blocks per tick, like the player's movement.
+*/
+class EntityStore : public Renderable, public WithTexture, public WithShader, Transformable, NonCopyable
+{
+public:
+    EntityStore() = default;
+    ~EntityStore();
+
+    void initialize();
+
+    void spawn(const glm::vec3& position, const glm::vec3& velocity,
+               const glm::vec3& halfSize, uint8_t block);
+    void clear();
+    int  count() const;
+
+    // world must not change while this runs
+    void update(const ChunkManager& world, float dt);
+
+    void setTransform(const glm::mat4& transform);
+    void render();
+
+    double getStepTimeMs() const;   // time of the last update
+    double getEntitiesPerMs() const;
+
+private:
+    void step(const ChunkManager& world, int i, float dt);
+    void remove(int i);
+
+private:
+    std::vector<glm::vec3>          m_position,
+                                    m_velocity,
+                                    m_halfSize;
+    std::vector<uint8_t>            m_block;
+    std::vector<uint8_t>            m_onGround; // not vector<bool>, it's written from several threads
+    std::vector<CollisionWindow>    m_windows;
+
+    std::vector<float>              m_instanceData;
+    unsigned int                    m_vao {0},
+                                    m_cubeVbo {0},
+                                    m_instanceVbo {0};
+
+    Timer                           m_stepTimer;
+    double                          m_stepTimeMs {0};
+    int                             m_steppedCount {0};
+};
+
+#endif // ENTITIES_H
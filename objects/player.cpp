@@ -2,14 +2,11 @@
 #include "graphics/camera.h"
 #include "chunkmanager.h"
 #include "playercontrols.h"
-#include "graphics/outline.h"
+#include "graphics/linebatch.h"
 #include "maths/geometry.h"
 
-#include <glm/geometric.hpp>
-#include <vector>
-#include <cmath>
-
 constexpr glm::vec3 Head {0, 1.4, 0};
+constexpr float PickDistance = 5;
 
 Player::Player(PControl control)
 {
@@ -43,6 +40,11 @@ void Player::update(float dt)
         m_camera->setPosition(m_control->getPosition() + Head);
 }
 
+double Player::getCollisionTimeMs() const
+{
+    return m_control->getCollisionTimeMs();
+}
+
 void Player::setPosition(glm::vec3 pos)
 {
     m_control->setPosition(pos);
@@ -100,65 +102,36 @@ glm::vec3 Player::getPosition() const
     return m_control->getPosition();
 }
 
-void Player::render()
+bool Player::pick(RaycastHit& hit) const
 {
-    int radius = 5;
-
     glm::vec3 head = m_control->getPosition() + Head;
-    glm::vec3 dir = m_control->getDirection();
-
-    int headx = std::floor(head.x);
-    int heady = std::floor(head.y);
-    int headz = std::floor(head.z);
-
-    int xmin = headx - radius;
-    int ymin = heady - radius;
-    int zmin = headz - radius;
+    return m_world->raycast(head, m_control->getDirection(), PickDistance, hit);
+}
 
-    int xmax = xmin + 2 * radius + 1;
-    int ymax = ymin + 2 * radius + 1;
-    int zmax = zmin + 2 * radius + 1;
+void Player::breakBlock()
+{
+    RaycastHit hit;
+    if (pick(hit))
+        m_world->set(hit.block, (uint8_t)Blocks::Type::None);
+}
 
-    glm::vec3 target;
-    bool found = false;
-    float distance = radius * 2;
+void Player::placeBlock(uint8_t type)
+{
+    RaycastHit hit;
+    if (!pick(hit))
+        return;
+    Position3 target {hit.block.x + hit.normal.x, hit.block.y + hit.normal.y, hit.block.z + hit.normal.z};
+    if (m_world->get(target) == (uint8_t)Blocks::Type::None)
+        m_world->set(target, type);
+}
 
-    for (int x = xmin; x <= xmax; x++)
-    for (int y = ymin; y <= ymax; y++)
-    for (int z = zmin; z <= zmax; z++)
+void Player::render()
+{
+    RaycastHit hit;
+    if (pick(hit))
     {
-        if ((headx - x) * (headx - x) + (heady - y) * (heady - y) + (headz - z) * (headz - z) > radius * radius)
-            continue;
-
-        if (m_world->get({x, y, z}) == static_cast<uint8_t>(Blocks::Type::None) ||
-            m_world->get({x, y, z}) == static_cast<uint8_t>(Blocks::Type::Water))
-            continue;
-
-        Geom::AABB box({x, y, z}, {x + 1, y + 1, z + 1});
-        auto triangles = box.getTriangles();
-        for (Geom::Triangle& triangle : triangles)
-        {
-            Geom::Plane plane = triangle.getPlane();
-            float distanceCurrent;
-            bool intersects = plane.vectorIntersects(head, dir, distanceCurrent);
-            if (intersects)
-            {
-                auto point = head + dir * distanceCurrent;
-                if (box.isPointInside(point) && distanceCurrent < distance)
-                {
-                    distance = distanceCurrent;
-                    target = glm::vec3(x, y, z);
-                    found = true;
-                }
-            }
-        }
+        glm::vec3 target {hit.block.x, hit.block.y, hit.block.z};
+        LineBatch::get().addBox(Geom::AABB(target - glm::vec3(0.01, 0.01, 0.01),
+                                           target + glm::vec3(1.01, 1.01, 1.01)), {0, 0, 0});
     }
-
-    if (found)
-        Outline::render(Geom::AABB(target - glm::vec3(0.01, 0.01, 0.01),
-                                   target + glm::vec3(1.01, 1.01, 1.01)));
 }
-
-
-
-
@@ -1,6 +1,7 @@
 #ifndef PLAYER_H
 #define PLAYER_H
 
+#include <cstdint>
 #include <memory>
 #include <glm/vec3.hpp>
 #include "playercontrols.h"
@@ -10,6 +11,7 @@ using PControl = std::unique_ptr<AbstractPlayerControl>;
 
 class Camera;
 class ChunkManager;
+struct RaycastHit;
 
 class Player : public Renderable
 {
@@ -34,6 +36,14 @@ public:
 
     void update(float dt);
     void render();
+    double getCollisionTimeMs() const;  // of the last update
+
+    // edit the block under the crosshair
+    void breakBlock();
+    void placeBlock(uint8_t type);
+
+private:
+    bool pick(RaycastHit& hit) const;
 
 private:
     PControl    m_control;
@@ -1,13 +1,16 @@
 #include "playercontrols.h"
 #include "maths/collision.h"
+#include "maths/voxelcollision.h"
 #include "chunkmanager.h"
 #include "player.h"
+#include "utils/constants.h"
+#include "utils/profiler.h"
 
 
 constexpr glm::vec3 Up {0, 1, 0};
 constexpr glm::vec3 BodyRadius {0.5, 1.5, 0.5};
+constexpr glm::vec3 BodyHalfSize {0.4, 1.5, 0.4}; // box used in VoxelAABB mode
 
-constexpr float g = 0.5f;
 constexpr float invSqrt2 = 1 / std::sqrt(2.0f);
 
 
@@ -42,6 +45,11 @@ void FlyingControl::update(float /*dt*/)
 
 // =========================================================================
 
+WalkingControl::WalkingControl(CollisionMode mode)
+    : m_collisionMode(mode)
+{
+}
+
 void WalkingControl::move(Dir dir, float offset)
 {
     glm::vec3 movement {0, 0, 0};
@@ -82,7 +90,8 @@ void WalkingControl::update(float dt)
     processCollisionsWithWorld();
     m_movementVec = {0, 0, 0};
 
-    m_verticalVelocity -= g * dt;
+    // vertical velocity is kept in the ellipsoid space, scaled by the body height
+    m_verticalVelocity -= Consts::GRAVITY / BodyRadius.y * dt;
 }
 
 void WalkingControl::jump()
@@ -91,7 +100,45 @@ void WalkingControl::jump()
         m_verticalVelocity = 0.2f;
 }
 
+double WalkingControl::getCollisionTimeMs() const
+{
+    return m_collisionTimeMs;
+}
+
 void WalkingControl::processCollisionsWithWorld()
+{
+    PROFILE_ZONE("collision");
+    m_collisionTimer.restart();
+    if (m_collisionMode == VoxelAABB)
+        collideVoxelAABB();
+    else
+        collideEllipsoid();
+    m_collisionTimeMs = m_collisionTimer.getElapsedSecs() * 1000;
+}
+
+void WalkingControl::collideVoxelAABB()
+{
+    // vertical velocity is scaled like in the ellipsoid space, so both modes jump and fall alike
+    glm::vec3 velocity = m_movementVec + glm::vec3 {0, m_verticalVelocity * BodyRadius.y, 0};
+    Geom::AABB box {m_pos - BodyHalfSize, m_pos + BodyHalfSize};
+
+    // window has to cover the box swept by velocity
+    m_window.update(*m_player->getWorldData(), {glm::min(box.min, box.min + velocity),
+                                                 glm::max(box.max, box.max + velocity)});
+
+    bool blocked[3];
+    m_pos += Collision::sweepAABB(box, velocity, m_window.region(), blocked);
+
+    if (blocked[1])
+    {
+        m_inAir = m_verticalVelocity > 0; // hit the ceiling
+        m_verticalVelocity = 0.0f;
+    }
+    else
+        m_inAir = true;
+}
+
+void WalkingControl::collideEllipsoid()
 {
     // Get nearest blocks for collision testing
     int xmin = std::floor(m_pos.x) - std::ceil(BodyRadius.x);
@@ -101,28 +148,15 @@ void WalkingControl::processCollisionsWithWorld()
     int zmin = std::floor(m_pos.z) - std::ceil(BodyRadius.z);
     int zmax = std::floor(m_pos.z) + std::ceil(BodyRadius.z);
 
-    // Extract triangles from these blocks for testing
-    std::vector<Geom::Triangle> triangles;
-    triangles.reserve((xmax - xmin + 1) * (ymax - ymin + 1) * (zmax - zmin + 1));
+    Geom::AABB nearest({xmin, ymin, zmin}, {xmax, ymax, zmax});
+    m_window.update(*m_player->getWorldData(), nearest);
+
+    // Extract exposed faces of these blocks for testing,
+    // transformed to new stretched space where player is a sphere
+    std::vector<Geom::Triangle>& triangles = m_triangles;
+    triangles.clear();
+    m_window.gatherTriangles(nearest, BodyRadius, triangles);
 
-    for (int x = xmin; x <= xmax; x++)
-    for (int y = ymin; y <= ymax; y++)
-    for (int z = zmin; z <= zmax; z++)
-    {
-        auto block = static_cast<Blocks::Type>(m_player->getWorldData()->get({x, y, z}));
-        if (block != Blocks::Type::None && block != Blocks::Type::Water)
-        {
-            Geom::AABB blockBox({x, y, z}, {x + 1, y + 1, z + 1});
-            auto boxTriangles = blockBox.getTriangles();
-            triangles.insert(std::end(triangles), std::begin(boxTriangles), std::end(boxTriangles));
-        }
-    }
-    // Transform to new stretched space where player is a sphere
-    for (Triangle& t : triangles) {
-        t.p1 /= BodyRadius;
-        t.p2 /= BodyRadius;
-        t.p3 /= BodyRadius;
-    }
     // Process possible collisions
     Collision::Packet packet;
 
@@ -1,7 +1,10 @@
 #ifndef PLAYERCONTROLS_H_INCLUDED
 #define PLAYERCONTROLS_H_INCLUDED
 
+#include <vector>
 #include <glm/vec3.hpp>
+#include "collisionwindow.h"
+#include "utils/timer.h"
 
 class Player;
 
@@ -14,6 +17,7 @@ public:
     virtual void move(Dir dir, float offset) = 0;
     virtual void update(float dt) = 0;
     virtual void jump() {};
+    virtual double getCollisionTimeMs() const {return 0;} // last tick, 0 without collisions
     void setPlayer(Player* player) {m_player = player;}
     void setPosition(glm::vec3 pos) {m_pos = pos;}
     glm::vec3 getPosition() {return m_pos;}
@@ -42,18 +46,35 @@ public:
 class WalkingControl : public AbstractPlayerControl
 {
 public:
+    // Ellipsoid: Fauerby's swept ellipsoid against block triangles
+    // VoxelAABB: axis-by-axis swept box against the block grid, no triangles
+    enum CollisionMode {Ellipsoid, VoxelAABB};
+
+    WalkingControl(CollisionMode mode = Ellipsoid);
+
     void move(Dir dir, float offset);
     void update(float dt);
     void jump();
+    double getCollisionTimeMs() const;
+
+    void setCollisionMode(CollisionMode mode)   {m_collisionMode = mode;}
+    CollisionMode getCollisionMode() const      {return m_collisionMode;}
 
 protected:
     void processCollisionsWithWorld();
+    void collideEllipsoid();
+    void collideVoxelAABB();
 
 protected:
-    float       m_verticalVelocity {0};
-    bool        m_inAir {true},
-                m_leftRight {false},
-                m_forwBack {false};
+    CollisionMode   m_collisionMode;
+    CollisionWindow m_window;
+    std::vector<Geom::Triangle> m_triangles; // reused between ticks
+    Timer           m_collisionTimer;
+    double          m_collisionTimeMs {0};
+    float           m_verticalVelocity {0};
+    bool            m_inAir {true},
+                    m_leftRight {false},
+                    m_forwBack {false};
 };
 
 #endif // PLAYERCONTROLS_H_INCLUDED
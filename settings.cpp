@@ -25,9 +25,8 @@ void Settings::setDefaults()
 {
     m_world.seed = 0;
     m_world.blockTextureName = "textures/blocks.png";
-    m_world.maxLoadsPerFrame = 5;
-    m_world.maxUpdatesPerFrame = 10;
-    m_world.maxExtraUpdatesPerFrame = 1;
+    m_world.streamBudgetMinMs = 1;
+    m_world.streamBudgetMaxMs = 8;
     m_world.maxChunkColsLoaded = 5000;
     m_world.chunksInCol = 4;
 
@@ -36,7 +35,9 @@ void Settings::setDefaults()
     m_rendering.fovy = 40;
     m_rendering.loadRadius = 20;
     m_rendering.fpsLimit = 60;
+    m_rendering.hitchMs = 33;
     m_rendering.vsync = true;
+    m_rendering.ambientOcclusion = true;
 
     m_skyboxTexturePaths = {
         "textures/ame_greenhaze/greenhaze_rt.tga",
@@ -116,8 +117,12 @@ bool Settings::parseRenderingParam(const std::string& name, const std::string& v
         m_rendering.loadRadius = parseInt(value, 1, 100, m_rendering.loadRadius);
     else if (name == "fps_limit")
         m_rendering.fpsLimit = parseInt(value, 0, 1000, m_rendering.fpsLimit);
+    else if (name == "hitch_ms")
+        m_rendering.hitchMs = parseInt(value, 1, 1000, m_rendering.hitchMs);
     else if (name == "vsync")
         m_rendering.vsync = parseInt(value, 0, 1, m_rendering.vsync);
+    else if (name == "ambient_occlusion")
+        m_rendering.ambientOcclusion = parseInt(value, 0, 1, m_rendering.ambientOcclusion);
     else
         ok = false;
     return ok;
@@ -130,12 +135,10 @@ bool Settings::parseWorldParam(const std::string& name, const std::string& value
         m_world.seed = parseInt(value, INT_MIN, INT_MAX, 0);
     else if (name == "blockTextures")
         m_world.blockTextureName = value;
-    else if (name == "max_loads_per_frame")
-        m_world.maxLoadsPerFrame = parseInt(value, 1, 100, m_world.maxLoadsPerFrame);
-    else if (name == "max_updates_per_frame")
-        m_world.maxUpdatesPerFrame = parseInt(value, 1, 100, m_world.maxUpdatesPerFrame);
-    else if (name == "max_extra_updates_per_frame")
-        m_world.maxExtraUpdatesPerFrame = parseInt(value, 1, 100, m_world.maxExtraUpdatesPerFrame);
+    else if (name == "stream_budget_min_ms")
+        m_world.streamBudgetMinMs = parseInt(value, 0, 50, m_world.streamBudgetMinMs);
+    else if (name == "stream_budget_max_ms")
+        m_world.streamBudgetMaxMs = parseInt(value, 1, 100, m_world.streamBudgetMaxMs);
     else if (name == "max_chunk_cols_loaded")
         m_world.maxChunkColsLoaded = parseInt(value, 100, 20000, m_world.maxChunkColsLoaded);
     else if (name == "chunks_in_column")
@@ -20,9 +20,8 @@ public:
     {
         int seed;
         std::string blockTextureName;
-        int maxLoadsPerFrame;
-        int maxUpdatesPerFrame;
-        int maxExtraUpdatesPerFrame;
+        int streamBudgetMinMs;
+        int streamBudgetMaxMs;
         int maxChunkColsLoaded;
         int chunksInCol;
     };
@@ -33,7 +32,9 @@ public:
         int fovy;
         int loadRadius;
         int fpsLimit;
+        int hitchMs;
         bool vsync;
+        bool ambientOcclusion;
     };
 
     World& world()              {return m_world;}
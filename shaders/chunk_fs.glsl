@@ -1,37 +1,37 @@
 #version 330
 
 in vec4 texCoord;
+in float brightness;
 out vec4 color;
-uniform sampler2D blockTexture;
+uniform sampler2DArray blockTexture; // layer = block type
 
 const vec4 fog_color = vec4(0.3f, 0.5f, 0.4f, 1.0f);
 const float fog_density = .00003;
 
 void main()
 {
+    // block coordinates wrap in the texture, no fract() so that mipmap selection stays continuous
     vec2 texPos;
-    float texOffset;
 
     if (texCoord.w > 0) // vertical faces
-    {
-        texOffset = texCoord.w - 1; // offset based on block type (w)
-        texPos = vec2((fract(texCoord.x + texCoord.z) + texOffset) / 16.0f, texCoord.y);
-    }
-    else if (texCoord.w < 0) // horizontal faces
-    {
-        texOffset = -texCoord.w - 1;
-        texPos = vec2((fract(texCoord.x) + texOffset) / 16.0f, texCoord.z);
-    }
-
-    color = texture(blockTexture, texPos);
+        texPos = vec2(texCoord.x + texCoord.z, texCoord.y);
+    else // horizontal faces
+        texPos = texCoord.xz;
+
+    color = texture(blockTexture, vec3(texPos, abs(texCoord.w)));
 
     if (texCoord.w > 0) // simulate diffusion lighting
-        color *= 0.6f;
+        color.rgb *= 0.6f;
+    color.rgb *= brightness;
 
-    if (color.a < 0.5f)
-        discard;
+#ifdef TRANSLUCENT
+    if (abs(texCoord.w) == 7) // water
+        color.a = 0.7f;
+#else
+    color.a = 1.0f; // opaque pass: no alpha test, keeps early depth testing
+#endif
 
     float z = gl_FragCoord.z / gl_FragCoord.w;
     float fog = clamp(exp(-fog_density * z * z), 0.2, 1);
-    color = mix(fog_color, color, fog);
+    color.rgb = mix(fog_color.rgb, color.rgb, fog);
 }
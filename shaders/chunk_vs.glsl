@@ -1,7 +1,9 @@
 #version 330
 
 layout (location = 0) in vec4 aPos;
+layout (location = 1) in vec4 aLight; // sky, block light 0..15, ambient occlusion 0..3
 out vec4 texCoord;
+out float brightness;
 
 uniform mat4 model;
 uniform mat4 proj_view;
@@ -21,4 +23,7 @@ void main()
 
 	gl_Position = proj_view * model * vec4(aPos.x, aPos.y + offs_y, aPos.z, 1);
 	texCoord = aPos;
+	// each light level is 80% as bright as the one above it
+	brightness = 0.05 + 0.95 * pow(0.8, 15 - max(aLight.x, aLight.y));
+	brightness *= mix(0.45, 1.0, aLight.z / 3);
 }
@@ -0,0 +1,16 @@
+#version 330
+
+in vec3 texPos;
+in float shade;
+out vec4 color;
+uniform sampler2DArray blockTexture;
+
+void main()
+{
+    color = texture(blockTexture, texPos);
+
+    if (color.a < 0.5f)
+        discard;
+
+    color.rgb *= shade;
+}
@@ -0,0 +1,19 @@
+#version 330
+
+layout (location = 0) in vec3 aPos;         // [-1, 1] cube
+layout (location = 1) in vec3 aTexShade;    // texture coords, shading
+layout (location = 2) in vec3 aCenter;      // per instance
+layout (location = 3) in vec3 aHalfSize;
+layout (location = 4) in float aBlock;
+
+out vec3 texPos;
+out float shade;
+
+uniform mat4 proj_view;
+
+void main()
+{
+    gl_Position = proj_view * vec4(aCenter + aPos * aHalfSize, 1);
+    texPos = vec3(aTexShade.xy, aBlock); // layer = block type
+    shade = aTexShade.z;
+}
@@ -3,8 +3,10 @@
 layout (location = 0) in vec4 coord;
 out vec2 texCoord;
 
+uniform mat4 projection;
+
 void main()
 {
-    gl_Position = vec4(coord.xy, 0, 1);
+    gl_Position = projection * vec4(coord.xy, 0, 1);
     texCoord = coord.zw;
 }
@@ -0,0 +1,8 @@
+#version 330
+
+in vec4 color;
+
+void main()
+{
+    gl_FragColor = color;
+}
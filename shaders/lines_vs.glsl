@@ -0,0 +1,14 @@
+#version 330
+
+layout (location = 0) in vec3 coord;
+layout (location = 1) in vec4 aColor;
+
+uniform mat4 proj_view;
+
+out vec4 color;
+
+void main()
+{
+    gl_Position = proj_view * vec4(coord, 1);
+    color = aColor;
+}
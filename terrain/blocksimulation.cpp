@@ -0,0 +1,217 @@
+#include "blocksimulation.h"
+#include "chunkmanager.h"
+#include "utils/threadpool.h"
+#include "utils/profiler.h"
+
+namespace
+{
+constexpr uint8_t None  = static_cast<uint8_t>(Blocks::Type::None);
+constexpr uint8_t Sand  = static_cast<uint8_t>(Blocks::Type::Sand);
+constexpr uint8_t Water = static_cast<uint8_t>(Blocks::Type::Water);
+constexpr uint8_t Unloaded = 0xff; // cells outside of loaded chunks don't move and can't be moved into
+
+constexpr int Sides[4][2] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+
+uint16_t packLocal(int x, int y, int z)
+{
+    using namespace Blocks;
+    return static_cast<uint16_t>((x << (CY_SHIFT + CZ_SHIFT)) | (y << CZ_SHIFT) | z);
+}
+
+Position3 unpackLocal(uint16_t local)
+{
+    using namespace Blocks;
+    return {local >> (CY_SHIFT + CZ_SHIFT), (local >> CZ_SHIFT) & CY_MASK, local & CZ_MASK};
+}
+
+// Read-only block access for the workers, remembers the last chunk like ChunkManager::get
+struct BlockReader
+{
+    const ChunkManager& world;
+    const Chunk*        chunk {nullptr};
+    Position3           index {0, -1, 0};
+
+    uint8_t get(int x, int y, int z)
+    {
+        using namespace Blocks;
+        Position3 i {x >> CX_SHIFT, y >> CY_SHIFT, z >> CZ_SHIFT};
+        if (!(i == index))
+        {
+            index = i;
+            chunk = world.getChunk(i);
+        }
+        if (!chunk)
+            return Unloaded;
+        return chunk->getRaw({x & CX_MASK, y & CY_MASK, z & CZ_MASK});
+    }
+};
+}
+
+void BlockSimulation::activateAround(const Position3& pos)
+{
+    activate(pos);
+    activate({pos.x - 1, pos.y, pos.z});
+    activate({pos.x + 1, pos.y, pos.z});
+    activate({pos.x, pos.y - 1, pos.z});
+    activate({pos.x, pos.y + 1, pos.z});
+    activate({pos.x, pos.y, pos.z - 1});
+    activate({pos.x, pos.y, pos.z + 1});
+}
+
+void BlockSimulation::activate(const Position3& pos)
+{
+    using namespace Blocks;
+    Position3 index {pos.x >> CX_SHIFT, pos.y >> CY_SHIFT, pos.z >> CZ_SHIFT};
+    m_active[index].insert(packLocal(pos.x & CX_MASK, pos.y & CY_MASK, pos.z & CZ_MASK));
+}
+
+void BlockSimulation::update(ChunkManager& world, float dt)
+{
+    m_accumulator += dt;
+    if (m_accumulator < StepSecs)
+        return;
+    // no catch-up, a late step just moves everything one cell as usual
+    m_accumulator = 0;
+    step(world);
+}
+
+void BlockSimulation::step(ChunkManager& world)
+{
+    PROFILE_ZONE("BlockSimulation::step");
+    m_tick++;
+    m_movesLastStep = 0;
+    m_activeCount = 0;
+    if (m_active.empty())
+    {
+        m_stepTimeMs = 0;
+        return;
+    }
+    m_timer.restart();
+
+    // cells activated while applying this step's moves belong to the next one
+    m_stepping.clear();
+    m_stepping.swap(m_active);
+
+    std::vector<std::pair<const Position3*, const CellSet*>> chunks;
+    chunks.reserve(m_stepping.size());
+    for (const auto& c : m_stepping)
+    {
+        chunks.emplace_back(&c.first, &c.second);
+        m_activeCount += c.second.size();
+    }
+
+    // 1. decide moves in parallel, the world is only read
+    m_moves.resize(chunks.size());
+    const ChunkManager& constWorld = world;
+    ThreadPool::get().parallelFor(chunks.size(), [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            m_moves[i].clear();
+            stepChunk(constWorld, *chunks[i].first, *chunks[i].second, m_moves[i]);
+        }
+    });
+
+    // 2. apply them in order. Two cells may have picked the same target,
+    //    a move whose cells no longer match is retried on the next step
+    for (size_t i = 0; i < chunks.size(); i++)
+    for (const Move& m : m_moves[i])
+    {
+        if (world.get(m.from) != m.block || world.get(m.to) != m.displaced)
+        {
+            activate(m.from);
+            continue;
+        }
+        world.set(m.to, m.block);
+        world.set(m.from, m.displaced);
+        m_movesLastStep++;
+    }
+
+    m_stepTimeMs = m_timer.getElapsedSecs() * 1000;
+}
+
+/*
+    Rules, evaluated against the world as it was at the start of the step:
+    - sand falls through air and sinks through water, otherwise slides down diagonally
+    - water falls, otherwise flows sideways towards an edge it can fall from,
+      and a stacked water cell spreads onto a free neighbour that has ground under it.
+    Every move either lowers a cell or ends its sideways flow, so the sets drain.
+*/
+void BlockSimulation::stepChunk(const ChunkManager& world, const Position3& index,
+                                const CellSet& cells, std::vector<Move>& moves) const
+{
+    using namespace Blocks;
+    BlockReader reader {world};
+
+    auto movable = [](uint8_t block) { return block == None || block == Water; };
+
+    for (uint16_t local : cells)
+    {
+        Position3 l = unpackLocal(local);
+        int x = index.x * CX + l.x, y = index.y * CY + l.y, z = index.z * CZ + l.z;
+
+        uint8_t block = reader.get(x, y, z);
+        if (block != Sand && block != Water)
+            continue;
+
+        // alternate the side scan order so that flows don't drift in one direction
+        int first = (m_tick + x + z) & 3;
+        uint8_t below = reader.get(x, y - 1, z);
+
+        if (block == Sand)
+        {
+            if (movable(below))
+            {
+                moves.push_back({{x, y, z}, {x, y - 1, z}, block, below});
+                continue;
+            }
+            for (int s = 0; s < 4; s++)
+            {
+                const int* d = Sides[(first + s) & 3];
+                uint8_t side = reader.get(x + d[0], y, z + d[1]);
+                uint8_t sideBelow = reader.get(x + d[0], y - 1, z + d[1]);
+                if (movable(side) && movable(sideBelow))
+                {
+                    moves.push_back({{x, y, z}, {x + d[0], y - 1, z + d[1]}, block, sideBelow});
+                    break;
+                }
+            }
+            continue;
+        }
+
+        if (below == None)
+        {
+            moves.push_back({{x, y, z}, {x, y - 1, z}, block, below});
+            continue;
+        }
+        for (int s = 0; s < 4; s++)
+        {
+            const int* d = Sides[(first + s) & 3];
+            if (reader.get(x + d[0], y, z + d[1]) != None)
+                continue;
+            uint8_t sideBelow = reader.get(x + d[0], y - 1, z + d[1]);
+            bool edge = sideBelow == None;
+            bool spread = below == Water && sideBelow != Water && sideBelow != Unloaded;
+            if (edge || spread)
+            {
+                moves.push_back({{x, y, z}, {x + d[0], y, z + d[1]}, block, None});
+                break;
+            }
+        }
+    }
+}
+
+int BlockSimulation::getActiveCount() const
+{
+    return m_activeCount;
+}
+
+int BlockSimulation::getMovesLastStep() const
+{
+    return m_movesLastStep;
+}
+
+float BlockSimulation::getStepTimeMs() const
+{
+    return m_stepTimeMs;
+}
@@ -0,0 +1,61 @@
+#ifndef BLOCKSIMULATION_H_INCLUDED
+#define BLOCKSIMULATION_H_INCLUDED
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "utils/position3.h"
+#include "utils/timer.h"
+
+class ChunkManager;
+
+/*
+    Falling sand and flowing water. Only cells next to a change are tracked, in sparse
+    per-chunk sets, so the cost of a step depends on the number of moving cells alone.
+    Moves are computed on the worker threads against the unchanged world, then applied
+    on the main thread through ChunkManager::set, which remeshes the touched chunks and
+    activates the cells around every move for the next step.
+*/
+class BlockSimulation
+{
+public:
+    static constexpr float StepSecs = 1 / 20.f;
+
+    // marks the block and its 6 neighbours for the next step, main thread only
+    void        activateAround(const Position3& pos);
+
+    // runs the steps due after dt seconds, at most one per call
+    void        update(ChunkManager& world, float dt);
+
+    int         getActiveCount() const;
+    int         getMovesLastStep() const;
+    float       getStepTimeMs() const;
+
+private:
+    struct Move
+    {
+        Position3   from, to;
+        uint8_t     block, displaced;
+    };
+
+    using CellSet = std::unordered_set<uint16_t>; // local block indices in a chunk
+
+    void        activate(const Position3& pos);
+    void        step(ChunkManager& world);
+    void        stepChunk(const ChunkManager& world, const Position3& index,
+                          const CellSet& cells, std::vector<Move>& moves) const;
+
+private:
+    std::unordered_map<Position3, CellSet> m_active, m_stepping;
+    std::vector<std::vector<Move>> m_moves;
+
+    float       m_accumulator {0};
+    unsigned    m_tick {0};
+    int         m_activeCount {0}, m_movesLastStep {0};
+    float       m_stepTimeMs {0};
+    Timer       m_timer;
+};
+
+#endif // BLOCKSIMULATION_H_INCLUDED
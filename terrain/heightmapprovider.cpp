@@ -2,6 +2,7 @@
 #include "noisegenerator.h"
 #include "utils/random.h"
 #include "../chunk.h"
+#include "utils/profiler.h"
 
 #include <iostream>
 
@@ -20,6 +21,7 @@ static Blocks::Type chooseBlock(float c);
 
 void fillChunkColumn(std::vector<Chunk>& column)
 {
+    PROFILE_ZONE("fillChunkColumn");
     const Position3& colPos = column[0].getIndex();
 
     int ix = colPos.x * Blocks::CX / 16.0f,
@@ -0,0 +1,368 @@
+#include "lightengine.h"
+#include "utils/timer.h"
+#include "utils/profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Blocks;
+
+namespace
+{
+constexpr int MaxLight = 15;
+constexpr int SkyShift = 4, BlockShift = 0;
+constexpr uint8_t Water = static_cast<uint8_t>(Type::Water);
+
+// same order as the border bits of LightEngine::Update
+constexpr int Dirs[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+constexpr int Down = 2;
+
+int levelOf(uint8_t light, int shift)
+{
+    return (light >> shift) & 0xf;
+}
+
+// level of light entering a block from a neighbour at 'level' along direction dir
+int attenuate(int level, int dir, uint8_t block, int shift)
+{
+    if (isOpaque(block))
+        return 0;
+    bool water = block == Water;
+    // full sky light falls through air without loss
+    if (shift == SkyShift && dir == Down && level == MaxLight && !water)
+        return MaxLight;
+    return std::max(0, level - (water ? 2 : 1));
+}
+}
+
+LightEngine::~LightEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    if (m_worker.joinable())
+        m_worker.join();
+}
+
+void LightEngine::start(int chunksInColumn)
+{
+    m_height = chunksInColumn * CY;
+    m_worker = std::thread(&LightEngine::workerLoop, this);
+}
+
+void LightEngine::loadColumn(const Position3& index, const std::vector<Chunk>& column)
+{
+    Job job(Job::Load, index);
+    job.blocks.resize(column.size() * ChunkVolume);
+    for (size_t y = 0; y < column.size(); y++)
+        memcpy(&job.blocks[y * ChunkVolume], column[y].getRawBlocks(), ChunkVolume);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.emplace_back(std::move(job));
+    m_cv.notify_one();
+}
+
+void LightEngine::unloadColumn(const Position3& index)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.emplace_back(Job::Unload, index);
+    m_cv.notify_one();
+}
+
+void LightEngine::setBlock(const Position3& pos, uint8_t type)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.emplace_back(Job::Set, pos, type);
+    m_cv.notify_one();
+}
+
+void LightEngine::collect(std::vector<Update>& updates)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& u : m_ready)
+        updates.emplace_back(std::move(u.second));
+    m_ready.clear();
+}
+
+void LightEngine::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCv.wait(lock, [this]{ return m_stop || (m_jobs.empty() && !m_busy); });
+}
+
+float LightEngine::getColumnTimeMs() const
+{
+    return m_columnTimeMs;
+}
+
+int LightEngine::getQueuedJobs() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size();
+}
+
+void LightEngine::workerLoop()
+{
+    Profiler::get().setThreadName("lighting");
+    std::deque<Job> jobs;
+    Timer timer;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stop || !m_jobs.empty(); });
+            if (m_stop)
+                return;
+            jobs.swap(m_jobs);
+            m_busy = true;
+        }
+
+        for (Job& job : jobs)
+        {
+            switch (job.type)
+            {
+            case Job::Load:
+                timer.restart();
+                load(job.pos, job.blocks);
+                m_columnTimeMs = timer.getElapsedSecs() * 1000;
+                break;
+            case Job::Unload:
+                m_columns.erase(job.pos);
+                m_lastColumn = nullptr;
+                break;
+            case Job::Set:
+                set(job.pos, job.block);
+                break;
+            }
+        }
+        jobs.clear();
+        publish();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy = false;
+        }
+        m_idleCv.notify_all();
+    }
+}
+
+bool LightEngine::locate(int x, int y, int z, Column*& column, int& i)
+{
+    if (y < 0 || y >= m_height)
+        return false;
+
+    Position3 index {x >> CX_SHIFT, 0, z >> CZ_SHIFT};
+    if (!m_lastColumn || !(m_lastColumnIndex == index))
+    {
+        auto it = m_columns.find(index);
+        if (it == m_columns.end())
+            return false;
+        m_lastColumn = &it->second;
+        m_lastColumnIndex = index;
+    }
+    column = m_lastColumn;
+    i = (y >> CY_SHIFT) * ChunkVolume +
+        ((x & CX_MASK) << (CY_SHIFT + CZ_SHIFT)) + ((y & CY_MASK) << CZ_SHIFT) + (z & CZ_MASK);
+    return true;
+}
+
+void LightEngine::setLevel(int x, int y, int z, Column& column, int i, int shift, int level)
+{
+    column.light[i] = (column.light[i] & ~(0xf << shift)) | (level << shift);
+
+    Position3 index {x >> CX_SHIFT, y >> CY_SHIFT, z >> CZ_SHIFT};
+    if (!m_lastDirty || !(m_lastDirtyIndex == index))
+    {
+        m_lastDirty = &m_dirty[index];
+        m_lastDirtyIndex = index;
+    }
+    int lx = x & CX_MASK, ly = y & CY_MASK, lz = z & CZ_MASK;
+    *m_lastDirty |= (lx == 0)  << 0 | (lx == CX_MASK) << 1 |
+                    (ly == 0)  << 2 | (ly == CY_MASK) << 3 |
+                    (lz == 0)  << 4 | (lz == CZ_MASK) << 5;
+}
+
+void LightEngine::spread(int shift)
+{
+    Column* column;
+    int i;
+    for (size_t head = 0; head < m_addQueue.size(); head++)
+    {
+        Node n = m_addQueue[head];
+        if (!locate(n.x, n.y, n.z, column, i))
+            continue;
+        int level = levelOf(column->light[i], shift);
+        if (level <= 1)
+            continue;
+
+        for (int d = 0; d < 6; d++)
+        {
+            int x = n.x + Dirs[d][0], y = n.y + Dirs[d][1], z = n.z + Dirs[d][2];
+            if (!locate(x, y, z, column, i))
+                continue;
+            int next = attenuate(level, d, column->blocks[i], shift);
+            if (next > levelOf(column->light[i], shift))
+            {
+                setLevel(x, y, z, *column, i, shift, next);
+                m_addQueue.push_back({x, y, z, 0});
+            }
+        }
+    }
+    m_addQueue.clear();
+}
+
+// Darkens everything that was lit through the cells in the remove queue. Cells lit
+// from elsewhere are left alone and queued to spread back into the darkened area.
+void LightEngine::unspread(int shift)
+{
+    Column* column;
+    int i;
+    for (size_t head = 0; head < m_removeQueue.size(); head++)
+    {
+        Node n = m_removeQueue[head];
+        for (int d = 0; d < 6; d++)
+        {
+            int x = n.x + Dirs[d][0], y = n.y + Dirs[d][1], z = n.z + Dirs[d][2];
+            if (!locate(x, y, z, column, i))
+                continue;
+            int level = levelOf(column->light[i], shift);
+            if (level == 0)
+                continue;
+
+            bool litFromHere = level < n.level ||
+                               (shift == SkyShift && d == Down && n.level == MaxLight && level == MaxLight);
+            if (litFromHere)
+            {
+                setLevel(x, y, z, *column, i, shift, 0);
+                m_removeQueue.push_back({x, y, z, (uint8_t)level});
+
+                int emission = shift == BlockShift ? lightEmission(column->blocks[i]) : 0;
+                if (emission > 0)
+                {
+                    setLevel(x, y, z, *column, i, shift, emission);
+                    m_addQueue.push_back({x, y, z, 0});
+                }
+            }
+            else
+                m_addQueue.push_back({x, y, z, 0});
+        }
+    }
+    m_removeQueue.clear();
+}
+
+void LightEngine::load(const Position3& index, std::vector<uint8_t>& blocks)
+{
+    PROFILE_ZONE("LightEngine::load");
+    Column& column = m_columns[index];
+    column.blocks = std::move(blocks);
+    column.light.assign(column.blocks.size(), 0);
+    m_lastColumn = nullptr;
+
+    int x0 = index.x * CX, z0 = index.z * CZ;
+    Column* c;
+    int i;
+
+    // sky light falls straight down from the top, then spreads sideways into
+    // overhangs and the neighbouring columns
+    for (int x = x0; x < x0 + CX; x++)
+    for (int z = z0; z < z0 + CZ; z++)
+    {
+        int level = MaxLight;
+        for (int y = m_height - 1; y >= 0 && level > 0; y--)
+        {
+            locate(x, y, z, c, i);
+            level = attenuate(level, Down, c->blocks[i], SkyShift);
+            c->light[i] |= level << SkyShift;
+            if (level > 1)
+                m_addQueue.push_back({x, y, z, 0});
+        }
+    }
+    // light of the neighbours' border cells flows in
+    auto seedFromNeighbours = [&]()
+    {
+        for (int y = 0; y < m_height; y++)
+        for (int k = 0; k < CX; k++)
+        {
+            m_addQueue.push_back({x0 - 1, y, z0 + k, 0});
+            m_addQueue.push_back({x0 + CX, y, z0 + k, 0});
+            m_addQueue.push_back({x0 + k, y, z0 - 1, 0});
+            m_addQueue.push_back({x0 + k, y, z0 + CZ, 0});
+        }
+    };
+    seedFromNeighbours();
+    spread(SkyShift);
+
+    for (int x = x0; x < x0 + CX; x++)
+    for (int y = 0; y < m_height; y++)
+    for (int z = z0; z < z0 + CZ; z++)
+    {
+        locate(x, y, z, c, i);
+        int emission = lightEmission(c->blocks[i]);
+        if (emission > 0)
+        {
+            c->light[i] |= emission << BlockShift;
+            m_addQueue.push_back({x, y, z, 0});
+        }
+    }
+    seedFromNeighbours();
+    spread(BlockShift);
+
+    // the whole column goes back to the main thread, its side neighbours remesh
+    // the faces that look into it
+    constexpr uint8_t sides = 1 << 0 | 1 << 1 | 1 << 4 | 1 << 5;
+    for (int y = 0; y < m_height / CY; y++)
+        m_dirty[{index.x, y, index.z}] |= sides;
+    m_lastDirty = nullptr;
+}
+
+void LightEngine::set(const Position3& pos, uint8_t type)
+{
+    PROFILE_ZONE("LightEngine::set");
+    Column* column;
+    int i;
+    if (!locate(pos.x, pos.y, pos.z, column, i))
+        return;
+    column->blocks[i] = type;
+
+    for (int shift : {SkyShift, BlockShift})
+    {
+        int old = levelOf(column->light[i], shift);
+        if (old > 0)
+        {
+            setLevel(pos.x, pos.y, pos.z, *column, i, shift, 0);
+            m_removeQueue.push_back({pos.x, pos.y, pos.z, (uint8_t)old});
+            unspread(shift);
+        }
+        // the neighbours may shine into a block that became transparent
+        for (int d = 0; d < 6; d++)
+            m_addQueue.push_back({pos.x + Dirs[d][0], pos.y + Dirs[d][1], pos.z + Dirs[d][2], 0});
+
+        int emission = shift == BlockShift ? lightEmission(type) : 0;
+        if (emission > 0)
+        {
+            setLevel(pos.x, pos.y, pos.z, *column, i, shift, emission);
+            m_addQueue.push_back({pos.x, pos.y, pos.z, 0});
+        }
+        spread(shift);
+    }
+}
+
+void LightEngine::publish()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& d : m_dirty)
+    {
+        auto it = m_columns.find({d.first.x, 0, d.first.z});
+        if (it == m_columns.end())
+            continue;
+
+        Update& update = m_ready[d.first];
+        update.index = d.first;
+        update.borders |= d.second;
+        memcpy(update.light.data(), &it->second.light[d.first.y * ChunkVolume], ChunkVolume);
+    }
+    m_dirty.clear();
+    m_lastDirty = nullptr;
+}
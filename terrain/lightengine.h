@@ -0,0 +1,117 @@
+#ifndef LIGHTENGINE_H_INCLUDED
+#define LIGHTENGINE_H_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _GLIBCXX_HAS_GTHREADS
+#include <mingw.thread.h>
+#include <mingw.mutex.h>
+#include <mingw.condition_variable.h>
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#include "chunk.h"
+#include "utils/noncopyable.h"
+#include "utils/position3.h"
+
+/*
+    Sky light and block light, 4 bits each, propagated by BFS on a worker thread.
+    The worker keeps its own copy of the blocks of every loaded column, fed by
+    loadColumn / setBlock in the order the world changes, so it never reads chunks.
+    Loading a column floods it; an edit removes and re-adds light only around the
+    changed block. Light of changed chunks is handed back through collect().
+*/
+class LightEngine : NonCopyable
+{
+public:
+    static constexpr int ChunkVolume = Blocks::CX * Blocks::CY * Blocks::CZ;
+
+    struct Update
+    {
+        Position3   index;              // chunk
+        uint8_t     borders {0};        // bit per face (-x, +x, -y, +y, -z, +z) whose neighbour chunk sees changed light
+        std::array<uint8_t, ChunkVolume> light;
+    };
+
+                ~LightEngine();
+
+    void        start(int chunksInColumn);
+
+    void        loadColumn(const Position3& index, const std::vector<Chunk>& column);
+    void        unloadColumn(const Position3& index);
+    void        setBlock(const Position3& pos, uint8_t type);
+
+    // moves out light computed since the last call
+    void        collect(std::vector<Update>& updates);
+    // blocks until every job queued so far is done and its light can be collected
+    void        wait();
+
+    float       getColumnTimeMs() const;   // flood fill of the last loaded column
+    int         getQueuedJobs() const;
+
+private:
+    struct Job
+    {
+        enum Type {Load, Unload, Set};
+
+        Job(Type type, const Position3& pos, uint8_t block = 0)
+            : type(type), pos(pos), block(block) {}
+
+        Type                    type;
+        Position3               pos;
+        uint8_t                 block;
+        std::vector<uint8_t>    blocks; // Load only
+    };
+
+    struct Column
+    {
+        std::vector<uint8_t>    blocks, light; // chunk after chunk, each laid out like Chunk
+    };
+
+    struct Node
+    {
+        int     x, y, z;
+        uint8_t level;
+    };
+
+    void        workerLoop();
+    void        load(const Position3& index, std::vector<uint8_t>& blocks);
+    void        set(const Position3& pos, uint8_t type);
+    void        publish();
+
+    bool        locate(int x, int y, int z, Column*& column, int& i);
+    void        setLevel(int x, int y, int z, Column& column, int i, int shift, int level);
+    void        spread(int shift);
+    void        unspread(int shift);
+
+private:
+    // worker thread only
+    std::unordered_map<Position3, Column>  m_columns;
+    Column*             m_lastColumn {nullptr};
+    Position3           m_lastColumnIndex;
+    std::unordered_map<Position3, uint8_t> m_dirty; // chunk -> border mask
+    uint8_t*            m_lastDirty {nullptr};
+    Position3           m_lastDirtyIndex;
+    std::vector<Node>   m_addQueue, m_removeQueue;
+    int                 m_height {0};
+
+    // shared
+    mutable std::mutex  m_mutex;
+    std::condition_variable m_cv, m_idleCv;
+    std::deque<Job>     m_jobs;
+    std::unordered_map<Position3, Update> m_ready;
+    bool                m_stop {false};
+    bool                m_busy {false};     // worker has jobs out of m_jobs
+    std::atomic<float>  m_columnTimeMs {0};
+    std::thread         m_worker;
+};
+
+#endif // LIGHTENGINE_H_INCLUDED
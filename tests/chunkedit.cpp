@@ -0,0 +1,129 @@
+/*
+    Regression check for editing closed chunks: a chunk whose faces are all hidden
+    meshes to nothing and is flagged empty, and breaking a block inside it or on
+    the border of its neighbour must still get it meshed again.
+
+    chunk_edit
+
+    Runs without a GL context, the few GL calls a chunk makes go to stand-ins.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+#include "chunkmanager.h"
+#include "settings.h"
+#include "graphics/frustrum.h"
+
+using namespace Blocks;
+
+namespace
+{
+constexpr int Radius = 2;
+constexpr int ChunksInColumn = 3;
+
+namespace FakeGL
+{
+GLuint nextName = 1;
+
+void APIENTRY genNames(GLsizei n, GLuint* names)
+{
+    for (GLsizei i = 0; i < n; i++)
+        names[i] = nextName++;
+}
+void APIENTRY deleteNames(GLsizei, const GLuint*) {}
+void APIENTRY bindVertexArray(GLuint) {}
+void APIENTRY bindBuffer(GLenum, GLuint) {}
+void APIENTRY enableVertexAttribArray(GLuint) {}
+void APIENTRY vertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+void APIENTRY bufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+
+void install()
+{
+    glGenVertexArrays = genNames;
+    glGenBuffers = genNames;
+    glDeleteVertexArrays = deleteNames;
+    glDeleteBuffers = deleteNames;
+    glBindVertexArray = bindVertexArray;
+    glBindBuffer = bindBuffer;
+    glEnableVertexAttribArray = enableVertexAttribArray;
+    glVertexAttribPointer = vertexAttribPointer;
+    glBufferData = bufferData;
+}
+}
+
+void fillStone(ChunkColumn& column)
+{
+    for (Chunk& chunk : column)
+        for (int x = 0; x < CX; x++)
+        for (int y = 0; y < CY; y++)
+        for (int z = 0; z < CZ; z++)
+            chunk.set({x, y, z}, Type::Stone);
+}
+
+size_t faces(const Chunk& chunk)
+{
+    std::vector<ChunkVertex> opaque, translucent;
+    chunk.buildMesh(opaque, translucent);
+    return (opaque.size() + translucent.size()) / 6;
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (condition)
+        return;
+    std::cerr << "FAILED: " << what << std::endl;
+    failures++;
+}
+}
+
+int main()
+{
+    FakeGL::install();
+    Settings::get().world().chunksInCol = ChunksInColumn;
+
+    Frustrum frustrum;
+    ChunkManager world(frustrum);
+    world.generateRegion({-Radius, 0, -Radius}, {Radius, 0, Radius}, fillStone);
+
+    // the middle chunk and the one next to it along x are closed on all sides
+    Chunk& middle = *world.getChunk({0, 1, 0});
+    Chunk& next = *world.getChunk({1, 1, 0});
+    middle.updateVBO();
+    next.updateVBO();
+    check(middle.empty() && !middle.changed(), "a closed chunk meshes to nothing");
+    check(next.empty() && !next.changed(), "its neighbour meshes to nothing");
+
+    // a block right in the middle of the chunk
+    world.set({CX / 2, CY + CY / 2, CZ / 2}, (uint8_t)Type::None);
+    check(!middle.empty() && middle.changed(), "breaking a block inside a closed chunk marks it for meshing");
+    middle.updateVBO();
+    check(!middle.empty(), "the chunk has faces around the hole");
+    check(faces(middle) == 6, "the hole has 6 faces, got " + std::to_string(faces(middle)));
+
+    // a block on the border faces the neighbour as well
+    world.set({CX - 1, CY + CY / 2, CZ / 2}, (uint8_t)Type::None);
+    check(!next.empty() && next.changed(), "breaking a block on the border marks the neighbour for meshing");
+    next.updateVBO();
+    check(!next.empty(), "the neighbour has a face towards the hole");
+    check(faces(next) == 1, "the neighbour has 1 face, got " + std::to_string(faces(next)));
+
+    // light doesn't add faces, so it leaves a closed chunk alone
+    Chunk& other = *world.getChunk({-1, 1, 0});
+    other.updateVBO();
+    std::vector<uint8_t> light(CX * CY * CZ, 0xf0);
+    other.setLight(light.data());
+    check(other.empty() && !other.changed(), "light on a closed chunk doesn't mark it for meshing");
+
+    if (failures)
+    {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "Edited closed chunks are meshed again" << std::endl;
+    return 0;
+}
@@ -0,0 +1,259 @@
+/*
+    Regression check for chunk meshing: builds a fixed region of made-up terrain
+    and light, meshes every chunk of it and compares a hash of each mesh with a
+    golden file.
+
+    mesh_verify <golden file> [--update]
+
+    The terrain comes from an integer hash rather than the noise generator, so the
+    golden doesn't depend on the libnoise build. The mesh hash ignores the order of
+    triangles and which vertex each triangle's list starts with, but not winding,
+    so a mesher that emits the same faces in a different order still passes.
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#include "chunkmanager.h"
+#include "settings.h"
+#include "graphics/frustrum.h"
+
+using namespace Blocks;
+
+namespace
+{
+constexpr int Radius = 4;           // columns around the origin that are checked
+constexpr int ChunksInColumn = 4;
+constexpr int WaterLevel = 26;
+
+struct MeshHash
+{
+    size_t      triangles {0};
+    uint64_t    hash {0};
+
+    bool operator==(const MeshHash& other) const
+    {
+        return triangles == other.triangles && hash == other.hash;
+    }
+};
+
+using Key = std::tuple<int, int, int>;
+using Hashes = std::map<Key, std::pair<MeshHash, MeshHash>>; // opaque, translucent
+
+uint32_t hash(int x, int y, int z)
+{
+    uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    return h ^ (h >> 15);
+}
+
+// Stepped hills with sand and water below WaterLevel, snow on top, holes in the
+// ground and a few glass and lamp blocks, so that every kind of face gets made.
+void fillColumn(ChunkColumn& column)
+{
+    for (Chunk& chunk : column)
+    {
+        const Position3& index = chunk.getIndex();
+        for (int x = 0; x < CX; x++)
+        for (int z = 0; z < CZ; z++)
+        {
+            int wx = index.x * CX + x, wz = index.z * CZ + z;
+            int height = 20 + hash(wx >> 2, 0, wz >> 2) % 16 + hash(wx, 1, wz) % 2;
+            for (int y = 0; y < CY; y++)
+            {
+                int wy = index.y * CY + y;
+                uint32_t h = hash(wx, wy, wz);
+                Type type = Type::None;
+                if (wy < height - 3)
+                    type = h % 11 == 0 ? Type::None : h % 37 == 0 ? Type::Lamp : Type::Stone;
+                else if (wy < height - 1)
+                    type = height <= WaterLevel + 1 ? Type::Sand : Type::Grass2;
+                else if (wy < height)
+                    type = height > 33 ? Type::Snow : height <= WaterLevel + 1 ? Type::Sand
+                         : h % 29 == 0 ? Type::Glass : Type::Grass1;
+                else if (wy <= WaterLevel)
+                    type = Type::Water;
+                if (type != Type::None)
+                    chunk.setRaw({x, y, z}, static_cast<uint8_t>(type));
+            }
+        }
+    }
+}
+
+void lightChunk(Chunk& chunk)
+{
+    static uint8_t light[CX][CY][CZ];
+    const Position3& index = chunk.getIndex();
+    for (int x = 0; x < CX; x++)
+    for (int y = 0; y < CY; y++)
+    for (int z = 0; z < CZ; z++)
+        light[x][y][z] = hash(index.x * CX + x, index.y * CY + y, index.z * CZ + z) >> 8;
+    chunk.setLight(&light[0][0][0]);
+}
+
+uint64_t mix(uint64_t x)
+{
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// the fields a vertex means, not its memory layout, so that packed formats compare the same
+uint64_t vertexKey(const ChunkVertex& v)
+{
+    const int fields[] = {v.pos.x, v.pos.y, v.pos.z, v.pos.w, v.light.x, v.light.y, v.light.z, v.light.w};
+    uint64_t key = 0;
+    for (int f : fields)
+        key = key << 8 | (uint8_t)f;
+    return key;
+}
+
+MeshHash hashMesh(const std::vector<ChunkVertex>& vertices)
+{
+    MeshHash result;
+    for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+    {
+        uint64_t k[3] = {vertexKey(vertices[i]), vertexKey(vertices[i + 1]), vertexKey(vertices[i + 2])};
+        // rotate the smallest vertex to the front, which keeps the winding
+        int first = std::min_element(k, k + 3) - k;
+        uint64_t h = mix(k[first]);
+        h = mix(h ^ k[(first + 1) % 3]);
+        h = mix(h ^ k[(first + 2) % 3]);
+        result.hash += h; // a sum doesn't care about triangle order
+        result.triangles++;
+    }
+    return result;
+}
+
+Hashes meshRegion()
+{
+    Settings& config = Settings::get();
+    config.world().chunksInCol = ChunksInColumn;
+    config.rendering().ambientOcclusion = true;
+
+    Frustrum frustrum;
+    ChunkManager world(frustrum);
+    // one more ring of columns, so that the faces on the border of the region are culled as usual
+    world.generateRegion({-Radius - 1, 0, -Radius - 1}, {Radius + 1, 0, Radius + 1}, fillColumn);
+    for (int x = -Radius - 1; x <= Radius + 1; x++)
+    for (int z = -Radius - 1; z <= Radius + 1; z++)
+    for (int y = 0; y < ChunksInColumn; y++)
+        lightChunk(*world.getChunk({x, y, z}));
+
+    Hashes hashes;
+    std::vector<ChunkVertex> opaque, translucent;
+    for (int x = -Radius; x <= Radius; x++)
+    for (int z = -Radius; z <= Radius; z++)
+    for (int y = 0; y < ChunksInColumn; y++)
+    {
+        world.getChunk({x, y, z})->buildMesh(opaque, translucent);
+        hashes[{x, y, z}] = {hashMesh(opaque), hashMesh(translucent)};
+    }
+    return hashes;
+}
+
+bool writeGolden(const std::string& file, const Hashes& hashes)
+{
+    std::ofstream out(file);
+    if (!out)
+        return false;
+
+    out << "# chunk meshing golden: radius " << Radius << ", " << ChunksInColumn
+        << " chunks per column, ambient occlusion on\n"
+        << "# x y z opaque_triangles opaque_hash translucent_triangles translucent_hash\n";
+    for (const auto& [key, mesh] : hashes)
+        out << std::dec << std::get<0>(key) << ' ' << std::get<1>(key) << ' ' << std::get<2>(key) << ' '
+            << mesh.first.triangles << ' ' << std::hex << mesh.first.hash << ' '
+            << std::dec << mesh.second.triangles << ' ' << std::hex << mesh.second.hash << '\n';
+    return true;
+}
+
+bool readGolden(const std::string& file, Hashes& hashes)
+{
+    std::ifstream in(file);
+    if (!in)
+        return false;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream ss(line);
+        int x, y, z;
+        MeshHash opaque, translucent;
+        if (ss >> x >> y >> z >> opaque.triangles >> std::hex >> opaque.hash
+               >> std::dec >> translucent.triangles >> std::hex >> translucent.hash)
+            hashes[{x, y, z}] = {opaque, translucent};
+        else
+            std::cerr << file << ": can't parse \"" << line << "\"" << std::endl;
+    }
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <golden file> [--update]" << std::endl;
+        return 2;
+    }
+    std::string goldenFile = argv[1];
+    Hashes hashes = meshRegion();
+
+    if (argc > 2 && std::string(argv[2]) == "--update")
+    {
+        if (!writeGolden(goldenFile, hashes))
+        {
+            std::cerr << "Can't write " << goldenFile << std::endl;
+            return 1;
+        }
+        std::cout << "Mesh golden for " << hashes.size() << " chunks written to " << goldenFile << std::endl;
+        return 0;
+    }
+
+    Hashes golden;
+    if (!readGolden(goldenFile, golden))
+    {
+        std::cerr << "Can't open " << goldenFile << std::endl;
+        return 1;
+    }
+
+    int mismatches = 0;
+    for (const auto& [key, mesh] : hashes)
+    {
+        auto it = golden.find(key);
+        if (it != golden.end() && it->second == mesh)
+            continue;
+
+        mismatches++;
+        std::cerr << "chunk " << std::get<0>(key) << ' ' << std::get<1>(key) << ' ' << std::get<2>(key) << ": ";
+        if (it == golden.end())
+            std::cerr << "not in the golden file\n";
+        else
+            std::cerr << "opaque " << mesh.first.triangles << " triangles (golden " << it->second.first.triangles
+                      << "), translucent " << mesh.second.triangles << " (golden " << it->second.second.triangles
+                      << ")" << (it->second.first.triangles == mesh.first.triangles &&
+                                 it->second.second.triangles == mesh.second.triangles ? ", hash differs" : "") << '\n';
+    }
+    if (golden.size() != hashes.size())
+        std::cerr << "golden file has " << golden.size() << " chunks, the region " << hashes.size() << '\n';
+
+    if (mismatches == 0 && golden.size() == hashes.size())
+    {
+        std::cout << "Meshes of " << hashes.size() << " chunks match " << goldenFile << std::endl;
+        return 0;
+    }
+    std::cerr << mismatches << " of " << hashes.size() << " chunk meshes differ from " << goldenFile << std::endl;
+    return 1;
+}
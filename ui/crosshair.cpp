@@ -1,22 +1,23 @@
 #include "crosshair.h"
+#include "graphics/glstate.h"
 #include "utils/drawcalltrack.h"
 
 void Crosshair::initialize()
 {
     glGenVertexArrays(1, &m_vao);
-    glBindVertexArray(m_vao);
+    GLState::bindVertexArray(m_vao);
     glGenBuffers(1, &m_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 4 * 4, nullptr, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 Crosshair::~Crosshair()
 {
-    glDeleteBuffers(1, &m_vbo);
-    glDeleteVertexArrays(1, &m_vao);
+    GLState::deleteBuffer(m_vbo);
+    GLState::deleteVertexArray(m_vao);
 }
 
 void Crosshair::setTransform(const glm::mat4& transform)
@@ -34,9 +35,8 @@ void Crosshair::setPosition(float px, float py)
         {px + 16, py + 16, 1, 1},
         {px     , py + 16, 0, 1}
     };
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
     glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof vertices, vertices);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void Crosshair::render()
@@ -44,9 +44,9 @@ void Crosshair::render()
     m_shader->use();
     m_texture->bind();
 
-    glBindVertexArray(m_vao);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::bindVertexArray(m_vao);
+    GLState::setEnabled(GL_BLEND, true);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDrawArrays_(GL_TRIANGLE_FAN, 0, 4);
-    glDisable(GL_BLEND);
+    GLState::setEnabled(GL_BLEND, false);
 }
@@ -0,0 +1,93 @@
+#include "framegraph.h"
+#include "graphics/glstate.h"
+#include "utils/drawcalltrack.h"
+#include "utils/framerecorder.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <glm/gtc/matrix_transform.hpp>
+
+constexpr int   Frames = 240;           // bars, one pixel each
+constexpr float Left = 10, Bottom = 10;
+constexpr float PixelsPerMs = 3;
+constexpr float MaxMs = 50;             // taller frames are clipped
+
+FrameGraph::~FrameGraph()
+{
+    GLState::deleteBuffer(m_vbo);
+    GLState::deleteVertexArray(m_vao);
+}
+
+void FrameGraph::initialize()
+{
+    glGenVertexArrays(1, &m_vao);
+    GLState::bindVertexArray(m_vao);
+    glGenBuffers(1, &m_vbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, (Frames * 4 + 4) * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    glEnableVertexAttribArray(1);
+    GLState::bindVertexArray(0);
+    m_vertices.reserve(Frames * 4 + 4);
+}
+
+void FrameGraph::setRecorder(const FrameRecorder* recorder)
+{
+    m_recorder = recorder;
+}
+
+void FrameGraph::setViewportSize(int width, int height)
+{
+    m_transform = glm::ortho(0.0f, (float)width, 0.0f, (float)height);
+}
+
+void FrameGraph::toggleActive()
+{
+    m_active = !m_active;
+}
+
+void FrameGraph::addLine(float x0, float y0, float x1, float y1, const glm::tvec4<uint8_t>& color)
+{
+    m_vertices.push_back({{x0, y0, 0}, color});
+    m_vertices.push_back({{x1, y1, 0}, color});
+}
+
+void FrameGraph::render()
+{
+    if (!m_active || !m_recorder)
+        return;
+
+    const glm::tvec4<uint8_t> cpu {60, 220, 60, 255}, hitch {240, 50, 50, 255},
+                              sleep {110, 110, 110, 255}, mark {230, 200, 40, 255};
+
+    m_vertices.clear();
+    auto height = [](float ms) { return std::min(ms, MaxMs) * PixelsPerMs; };
+
+    int count = std::min(Frames, m_recorder->getRecentCount());
+    int first = m_recorder->getRecentCount() - count;
+    for (int i = 0; i < count; i++)
+    {
+        const FrameRecorder::Frame& f = m_recorder->getRecent(first + i);
+        float x = Left + Frames - count + i + 0.5f;
+        float top = Bottom + height(f.cpuMs);
+        addLine(x, Bottom, x, top, f.totalMs() > m_recorder->getHitchThreshold() ? hitch : cpu);
+        if (f.sleepMs > 0)
+            addLine(x, top, x, Bottom + height(f.totalMs()), sleep);
+    }
+    for (float ms : {1000 / 60.0f, 1000 / 30.0f})
+        addLine(Left, Bottom + height(ms), Left + Frames, Bottom + height(ms), mark);
+
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_vertices.size() * sizeof(Vertex), m_vertices.data());
+
+    // the line shader is shared with the world-space batch, which sets its own transform
+    m_shader->use();
+    m_shader->setMat4("proj_view", &m_transform[0][0]);
+    GLState::bindVertexArray(m_vao);
+    GLState::setEnabled(GL_DEPTH_TEST, false);
+    glLineWidth(1);
+    glDrawArrays_(GL_LINES, 0, m_vertices.size());
+    GLState::setEnabled(GL_DEPTH_TEST, true);
+}
@@ -0,0 +1,47 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "graphics/renderable.h"
+
+class FrameRecorder;
+
+/*
+    Bar per recent frame in the bottom left corner: CPU time in green (red for a
+    hitch) with the limiter's sleep stacked on top in grey, against 60 and 30 fps
+    marks. Drawn with the line shader in pixels.
+*/
+class FrameGraph : public Renderable, public WithShader
+{
+public:
+    FrameGraph() = default;
+    ~FrameGraph();
+
+    void initialize();
+    void setRecorder(const FrameRecorder* recorder);
+    void setViewportSize(int width, int height);
+    void toggleActive();
+    void render();
+
+private:
+    struct Vertex
+    {
+        glm::vec3               pos;
+        glm::tvec4<uint8_t>     color;
+    };
+
+    void addLine(float x0, float y0, float x1, float y1, const glm::tvec4<uint8_t>& color);
+
+    const FrameRecorder*    m_recorder {nullptr};
+    glm::mat4               m_transform {1};
+    std::vector<Vertex>     m_vertices;
+    unsigned int            m_vao {0}, m_vbo {0};
+    bool                    m_active {true};
+};
+
+#endif // FRAMEGRAPH_H
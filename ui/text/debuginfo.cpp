@@ -4,7 +4,7 @@
 
 DebugInfo::DebugInfo()
 {
-    m_text.setPosition(1, 50);
+    m_text.setPosition(1, 90);
 }
 
 void DebugInfo::setPositionInfo(float x, float y, float z)
@@ -34,13 +34,97 @@ void DebugInfo::setTriangleCount(int count)
     m_triangles = count;
 }
 
+void DebugInfo::setUniformSetCount(int count, int redundant)
+{
+    m_uniformSets = count;
+    m_redundantUniformSets = redundant;
+}
+
+void DebugInfo::setStateChangeCount(int issued, int skipped)
+{
+    m_stateChanges = issued;
+    m_skippedStateChanges = skipped;
+}
+
+void DebugInfo::setStreamingInfo(float spentMs, float budgetMs)
+{
+    m_streamSpent = spentMs;
+    m_streamBudget = budgetMs;
+}
+
+void DebugInfo::setEntityInfo(int count, float stepMs, float perMs)
+{
+    m_entities = count;
+    m_entityStep = stepMs;
+    m_entitiesPerMs = perMs;
+}
+
+void DebugInfo::setSimulationInfo(int activeCells, int moves, float stepMs)
+{
+    m_simCells = activeCells;
+    m_simMoves = moves;
+    m_simStep = stepMs;
+}
+
+void DebugInfo::setLightingInfo(float columnMs, int queuedJobs)
+{
+    m_lightColumn = columnMs;
+    m_lightJobs = queuedJobs;
+}
+
+void DebugInfo::setMeshingInfo(float chunkMs, bool ambientOcclusion)
+{
+    m_meshTime = chunkMs;
+    m_ambientOcclusion = ambientOcclusion;
+}
+
+void DebugInfo::setProfileInfo(const std::vector<Profiler::ZoneStat>& zones)
+{
+    m_zones = zones;
+}
+
+void DebugInfo::setGpuInfo(const std::vector<GpuTimer::PassStat>& passes, bool supported)
+{
+    m_gpuPasses = passes;
+    m_gpuSupported = supported;
+}
+
 void DebugInfo::updateText()
 {
     std::stringstream ss;
     ss << std::fixed << std::setprecision(2) <<
     "pos: " << m_pos[0] << "; " << m_pos[1] << "; " << m_pos[2] <<
     ";\ndir: " << m_dir[0] << "; " << m_dir[1] << "; " << m_dir[2] <<
-    ";\ndraw calls: " << m_drawCalls << "\ntriangles: " << m_triangles;
+    ";\ndraw calls: " << m_drawCalls << "\ntriangles: " << m_triangles <<
+    "\nuniform sets: " << m_uniformSets << " (" << m_redundantUniformSets << " redundant, skipped)" <<
+    "\nstate changes: " << m_stateChanges << " (" << m_skippedStateChanges << " skipped)" <<
+    "\nstreaming: " << m_streamSpent << " / " << m_streamBudget << " ms" <<
+    "\nentities: " << m_entities << ", step " << m_entityStep << " ms (" << m_entitiesPerMs << " / ms)" <<
+    "\nblock updates: " << m_simCells << " active, " << m_simMoves << " moved, " << m_simStep << " ms" <<
+    "\nlight: " << m_lightColumn << " ms / column, " << m_lightJobs << " jobs queued" <<
+    "\nmeshing: " << m_meshTime << " ms / chunk, AO " << (m_ambientOcclusion ? "on" : "off");
+
+    if (!m_zones.empty())
+        ss << "\nprofile (ms / frame, calls):";
+    constexpr size_t MaxZones = 8;
+    for (size_t i = 0; i < m_zones.size() && i < MaxZones; i++)
+    {
+        const auto& zone = m_zones[i];
+        ss << "\n  " << std::string(zone.depth * 2, ' ') << zone.name << ": "
+           << zone.ms << ", " << std::setprecision(0) << zone.calls << std::setprecision(2);
+    }
+
+    if (!m_gpuSupported && !m_zones.empty())
+        ss << "\ngpu: timer queries unavailable";
+    if (!m_gpuPasses.empty())
+    {
+        float total = 0;
+        for (const auto& pass : m_gpuPasses)
+            total += pass.ms;
+        ss << "\ngpu: " << total << " ms / frame";
+        for (const auto& pass : m_gpuPasses)
+            ss << "\n  " << pass.name << ": " << pass.ms;
+    }
     m_text.setText(ss.str());
 }
 
@@ -2,6 +2,10 @@
 #define DEBUGINFO_H
 
 #include "textfield.h"
+#include "graphics/gputimer.h"
+#include "utils/profiler.h"
+
+#include <vector>
 
 class DebugInfo : public TextField
 {
@@ -12,6 +16,15 @@ public:
     void setViewDirectionInfo(float x, float y, float z);
     void setDrawCallCount(int count);
     void setTriangleCount(int count);
+    void setUniformSetCount(int count, int redundant);
+    void setStateChangeCount(int issued, int skipped);
+    void setStreamingInfo(float spentMs, float budgetMs);
+    void setEntityInfo(int count, float stepMs, float perMs);
+    void setSimulationInfo(int activeCells, int moves, float stepMs);
+    void setLightingInfo(float columnMs, int queuedJobs);
+    void setMeshingInfo(float chunkMs, bool ambientOcclusion);
+    void setProfileInfo(const std::vector<Profiler::ZoneStat>& zones);  // empty hides the breakdown
+    void setGpuInfo(const std::vector<GpuTimer::PassStat>& passes, bool supported);
     void render();
 
 private:
@@ -21,6 +34,20 @@ private:
     float       m_pos[3];
     float       m_dir[3];
     int         m_drawCalls {0}, m_triangles {0};
+    int         m_uniformSets {0}, m_redundantUniformSets {0};
+    int         m_stateChanges {0}, m_skippedStateChanges {0};
+    float       m_streamSpent {0}, m_streamBudget {0};
+    int         m_entities {0};
+    float       m_entityStep {0}, m_entitiesPerMs {0};
+    int         m_simCells {0}, m_simMoves {0};
+    float       m_simStep {0};
+    float       m_lightColumn {0};
+    int         m_lightJobs {0};
+    float       m_meshTime {0};
+    bool        m_ambientOcclusion {false};
+    std::vector<Profiler::ZoneStat> m_zones;
+    std::vector<GpuTimer::PassStat> m_gpuPasses;
+    bool        m_gpuSupported {true};
     bool        m_textNeedsUpdate {true};
 };
 
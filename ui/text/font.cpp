@@ -1,36 +1,33 @@
 #include "font.h"
 
-#include <cmath>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "text.h"
 #include "ftlibrary.h"
 
+#include "graphics/glstate.h"
 #include "utils/drawcalltrack.h"
 
-Font::Font(GLFWwindow* context)
-    : m_context(context)
+namespace
 {
+constexpr int MaxAtlasHeight = 4096;
+constexpr size_t AsciiCount = 127 - 32; // rasterized up front, these have to fit
+constexpr int Padding = 1; // keeps linear filtering from picking up the neighbour
 }
 
 Font::~Font()
 {
-    clearGlyphData();
     if (m_faceLoaded)
         FT_Done_Face(m_ftFace);
-    glDeleteBuffers(1, &m_vbo);
-    glDeleteVertexArrays(1, &m_vao);
-}
-
-void Font::setContext(GLFWwindow* context)
-{
-    m_context = context;
+    GLState::deleteTexture(m_atlas);
 }
 
 void Font::setSize(unsigned size)
@@ -38,7 +35,7 @@ void Font::setSize(unsigned size)
     if (FT_Set_Pixel_Sizes(m_ftFace, 0, size))
         onError("FT_Set_Pixel_Sizes failed");
     m_size = size;
-    m_glyphDataNeedsUpdate = true;
+    m_atlasNeedsUpdate = true;
 }
 
 unsigned Font::size() const
@@ -46,20 +43,30 @@ unsigned Font::size() const
     return m_size;
 }
 
+void Font::setViewportSize(int width, int height)
+{
+    initGLStuff();
+    glm::mat4 projection = glm::ortho(0.0f, (float)width, (float)height, 0.0f);
+    m_shader.use();
+    m_shader.setMat4("projection", &projection[0][0]);
+}
+
 void Font::initGLStuff()
 {
     if (!m_glStuffInitialized)
     {
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glGenVertexArrays(1, &m_vao);
-        glBindVertexArray(m_vao);
-        glGenBuffers(1, &m_vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        glBufferData(GL_ARRAY_BUFFER, 4 * 4 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(0);
-        glBindVertexArray(0);
+        glGenTextures(1, &m_atlas);
+        GLState::bindTexture(0, GL_TEXTURE_2D, m_atlas);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         m_shader.load("shaders/freetype_vs.glsl", "shaders/freetype_fs.glsl");
+
+        GLint maxTextureSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+        m_maxAtlasHeight = std::min(MaxAtlasHeight, (int)maxTextureSize);
         m_glStuffInitialized = true;
     }
 }
@@ -75,118 +82,150 @@ void Font::loadFromFile(const std::string& file)
     m_faceLoaded = true;
     if (FT_Set_Pixel_Sizes(m_ftFace, 0, m_size))
         onError("FT_Set_Pixel_Sizes failed");
+    m_atlasNeedsUpdate = true;
 }
 
-void Font::loadGlyphData()
+// Rasterizes everything into memory and uploads the atlas at once
+void Font::buildAtlas()
 {
     initGLStuff();
-    clearGlyphData();
 
-    for (unsigned char c = 0; c < 128; c++)
+    std::vector<uint32_t> codepoints;
+    for (uint32_t c = 32; c < 127; c++)
+        codepoints.push_back(c);
+    for (const auto& g : m_glyphs)
+        if (g.first < 32 || g.first >= 127)
+            codepoints.push_back(g.first);
+
+    std::vector<unsigned char> pixels;
+    while (true)
     {
-        if (FT_Load_Char(m_ftFace, c, FT_LOAD_RENDER)) {
-            std::cerr << "FT_Load_Char failed" << std::endl;
-            continue;
+        m_glyphs.clear();
+        m_penX = m_penY = m_rowHeight = 0;
+        pixels.assign(m_atlasWidth * m_atlasHeight, 0);
+
+        size_t packed = 0;
+        for (; packed < codepoints.size(); packed++)
+        {
+            Glyph g;
+            if (!rasterize(codepoints[packed], g, &pixels))
+                break;
+            m_glyphs[codepoints[packed]] = g;
+        }
+        if (packed == codepoints.size())
+            break;
+        if (m_atlasHeight >= m_maxAtlasHeight)
+        {
+            if (packed < AsciiCount)
+                onError("Glyph atlas is full");
+            // the code points that don't fit any more look like '?'
+            for (; packed < codepoints.size(); packed++)
+                m_glyphs[codepoints[packed]] = m_glyphs['?'];
+            break;
         }
-        GLuint texture;
-        glGenTextures(1, &texture);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        m_atlasHeight = std::min(m_atlasHeight * 2, m_maxAtlasHeight);
+    }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, m_ftFace->glyph->bitmap.width,
-                     m_ftFace->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE,
-                     m_ftFace->glyph->bitmap.buffer);
+    GLState::bindTexture(0, GL_TEXTURE_2D, m_atlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_atlasWidth, m_atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    m_generation++;
+}
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+// Packs the glyph into the next free spot of the atlas. Written to 'pixels' when
+// building, straight into the texture otherwise. False if it doesn't fit
+bool Font::rasterize(uint32_t codepoint, Glyph& g, std::vector<unsigned char>* pixels)
+{
+    // code points the face doesn't have look like '?'
+    FT_UInt index = FT_Get_Char_Index(m_ftFace, codepoint);
+    if (index == 0)
+        index = FT_Get_Char_Index(m_ftFace, '?');
+    if (FT_Load_Glyph(m_ftFace, index, FT_LOAD_RENDER))
+    {
+        std::cerr << "FT_Load_Glyph failed" << std::endl;
+        g = Glyph {0, 0, 0, 0, 0, 0, 0, 0, 0};
+        return true;
+    }
 
-        GlyphInfo g = {
-            texture,
-            m_ftFace->glyph->bitmap.width,
-            m_ftFace->glyph->bitmap.rows,
-            m_ftFace->glyph->bitmap_left,
-            m_ftFace->glyph->bitmap_top,
-            m_ftFace->glyph->advance.x,
-            m_ftFace->glyph->advance.y
-        };
-        m_glyphInfoMap.insert(std::pair<char, GlyphInfo>(c, g));
+    const FT_Bitmap& bitmap = m_ftFace->glyph->bitmap;
+    int w = bitmap.width, h = bitmap.rows;
+    if (m_penX + w + Padding > m_atlasWidth)
+    {
+        m_penX = 0;
+        m_penY += m_rowHeight + Padding;
+        m_rowHeight = 0;
     }
-}
+    if (m_penY + h + Padding > m_atlasHeight)
+        return false;
 
-void Font::clearGlyphData()
-{
-    for (auto& i : m_glyphInfoMap)
-        glDeleteTextures(1, &i.second.textureID);
-    m_glyphInfoMap.clear();
+    if (pixels)
+    {
+        for (int row = 0; row < h; row++)
+            memcpy(&(*pixels)[(m_penY + row) * m_atlasWidth + m_penX], bitmap.buffer + row * bitmap.pitch, w);
+    }
+    else if (w > 0 && h > 0)
+    {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, bitmap.pitch);
+        GLState::bindTexture(0, GL_TEXTURE_2D, m_atlas);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, m_penX, m_penY, w, h, GL_RED, GL_UNSIGNED_BYTE, bitmap.buffer);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    g.u0 = (float)m_penX / m_atlasWidth;
+    g.v0 = (float)m_penY / m_atlasHeight;
+    g.u1 = (float)(m_penX + w) / m_atlasWidth;
+    g.v1 = (float)(m_penY + h) / m_atlasHeight;
+    g.width = w;
+    g.height = h;
+    g.left = m_ftFace->glyph->bitmap_left;
+    g.top = m_ftFace->glyph->bitmap_top;
+    g.advance = m_ftFace->glyph->advance.x >> 6;
+
+    m_penX += w + Padding;
+    m_rowHeight = std::max(m_rowHeight, h);
+    return true;
 }
 
-void Font::setColor(float* color)
+const Font::Glyph& Font::glyph(uint32_t codepoint)
 {
-    initGLStuff();
-    m_shader.use();
-    m_shader.setVec4("color", color);
+    auto it = m_glyphs.find(codepoint);
+    if (it != m_glyphs.end())
+        return it->second;
+
+    Glyph g;
+    if (rasterize(codepoint, g, nullptr))
+        return m_glyphs[codepoint] = g;
+
+    // no room left for good, so it looks like the code points the face doesn't have
+    if (m_atlasHeight >= m_maxAtlasHeight)
+        return m_glyphs[codepoint] = m_glyphs['?'];
+
+    // full, start over with more room; the new code point is taken along
+    m_glyphs[codepoint] = g;
+    m_atlasHeight = std::min(m_atlasHeight * 2, m_maxAtlasHeight);
+    buildAtlas();
+    return m_glyphs[codepoint];
 }
 
-void Font::renderText(const std::string& text, float px, float py)
+unsigned Font::generation()
 {
-    if (!m_context)
-        return;
-
-    int w, h;
-    glfwGetFramebufferSize(m_context, &w, &h);
-
-    float sx = 2.0 / w,
-          sy = 2.0 / h;
-    float x = -1.0 + px * sx,
-          y =  1.0 - py * sy;
-
-    if (m_glyphDataNeedsUpdate)
+    if (m_atlasNeedsUpdate)
     {
-        loadGlyphData();
-        m_glyphDataNeedsUpdate = false;
+        buildAtlas();
+        m_atlasNeedsUpdate = false;
     }
-    m_shader.use();
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glBindVertexArray(m_vao);
-
-    for (auto c = text.begin(); c != text.end(); ++c)
-    {
-        GlyphInfo gi = m_glyphInfoMap[*c];
-
-        float x2 = x + gi.left * sx;
-        float y2 = -y - gi.top * sy;
-        float w = gi.width * sx;
-        float h = gi.height * sy;
+    return m_generation;
+}
 
-        if (*c == '\n')
-        {
-            x = -1.0 + px * sx;
-            y -= m_size * sy;
-        }
-        else
-        {
-            GLfloat box[4][4] = {
-                /* position     | texture coord */
-                {x2,     -y2 - h, 0, 1},
-                {x2 + w, -y2 - h, 1, 1},
-                {x2,     -y2,     0, 0},
-                {x2 + w, -y2,     1, 0},
-            };
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, gi.textureID);
-            glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(box), box);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glDrawArrays_(GL_TRIANGLE_STRIP, 0, 4);
-
-            x += (gi.advance_x >> 6) * sx;
-            y += (gi.advance_y >> 6) * sy;
-        }
-    }
-    glDisable(GL_BLEND);
+void Font::draw(unsigned vao, int vertexCount, const float* color)
+{
+    m_shader.use();
+    m_shader.setVec4("color", color);
+    GLState::bindTexture(0, GL_TEXTURE_2D, m_atlas);
+    GLState::setEnabled(GL_BLEND, true);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::bindVertexArray(vao);
+    glDrawArrays_(GL_TRIANGLES, 0, vertexCount);
+    GLState::setEnabled(GL_BLEND, false);
 }
 
 void Font::onError(const std::string& message)
@@ -1,8 +1,10 @@
 #ifndef FONT_H
 #define FONT_H
 
-#include <map>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "graphics/shader.h"
 #include "utils/noncopyable.h"
 
@@ -10,47 +12,58 @@
 class FT_FaceRec_;
 using FT_Face = FT_FaceRec_*;
 
-class GLFWwindow;
 class Text;
 
+/*
+    Glyphs of one face and size packed into a single texture. Printable ASCII is
+    rasterized up front, any other code point when a Text first uses it. When the
+    atlas is full it is rebuilt twice as high, which bumps generation() so that
+    texts rebuild their vertices. Past the height limit new code points are drawn
+    as '?'.
+*/
 class Font : NonCopyable
 {
 public:
     Font() = default;
-    Font(GLFWwindow* context);
     ~Font();
 
     void loadFromFile(const std::string& file);
-    void setContext(GLFWwindow* context);
     void setSize(unsigned size);
     unsigned size() const;
 
+    // text is laid out in pixels from the top left corner of the viewport
+    void setViewportSize(int width, int height);
+
 private:
+    struct Glyph
+    {
+        float   u0, v0, u1, v1;
+        int     width, height, left, top, advance;
+    };
+
     void initGLStuff();
-    void loadGlyphData();
-    void clearGlyphData();
-    void setColor(float* color);
-    void renderText(const std::string& text, float px, float py);
+    void buildAtlas();
+    bool rasterize(uint32_t codepoint, Glyph& glyph, std::vector<unsigned char>* pixels);
+    const Glyph& glyph(uint32_t codepoint);
+    unsigned generation();
+    void draw(unsigned vao, int vertexCount, const float* color);
     void onError(const std::string& message);
 
 private:
-    bool m_glyphDataNeedsUpdate {true};
+    bool m_atlasNeedsUpdate     {true};
     bool m_glStuffInitialized   {false};
     bool m_faceLoaded           {false};
 
-    GLFWwindow* m_context {nullptr};
     FT_Face     m_ftFace;
-
-    unsigned    m_vao {0}, m_vbo {0};
     Shader      m_shader;
-
     unsigned    m_size {24};
 
-    struct GlyphInfo {
-        unsigned textureID, width, height;
-        int left, top, advance_x, advance_y;
-    };
-    std::map<char, GlyphInfo> m_glyphInfoMap;
+    unsigned    m_atlas {0};
+    int         m_atlasWidth {256}, m_atlasHeight {256};
+    int         m_maxAtlasHeight {0}; // known once there is a GL context
+    int         m_penX {0}, m_penY {0}, m_rowHeight {0}; // shelf packing
+    unsigned    m_generation {0};
+    std::unordered_map<uint32_t, Glyph> m_glyphs;
 
     friend class Text;
 };
@@ -1,8 +1,12 @@
 #include "fpscounter.h"
+#include "utils/framerecorder.h"
+
+#include <iomanip>
+#include <sstream>
 
 constexpr double period = 0.5;
 
-void FPSCounter::tick()
+void FPSCounter::tick(const FrameRecorder& frames)
 {
     m_count++;
     m_elapsed = m_timer.getElapsedSecs();
@@ -11,6 +15,15 @@ void FPSCounter::tick()
         m_fps = m_count / m_elapsed;
         m_timer.restart();
         m_count = 0;
-        m_text.setText("FPS: " + std::to_string((int)m_fps));
+
+        FrameRecorder::Summary frame = frames.getFrameSummary();
+        FrameRecorder::Summary cpu = frames.getCpuSummary();
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1) <<
+        "FPS: " << (int)m_fps <<
+        "\nframe ms p50/95/99/max: " << frame.p50 << " / " << frame.p95 << " / " << frame.p99 << " / " << frame.max <<
+        "\ncpu ms p50/95/99/max: " << cpu.p50 << " / " << cpu.p95 << " / " << cpu.p99 << " / " << cpu.max <<
+        "\nhitches > " << frames.getHitchThreshold() << " ms: " << frames.getHitchCount();
+        m_text.setText(ss.str());
     }
 }
@@ -4,11 +4,14 @@
 #include "textfield.h"
 #include "utils/timer.h"
 
+class FrameRecorder;
+
+// average FPS plus frame time percentiles and hitches, refreshed twice a second
 class FPSCounter : public TextField
 {
 public:
     FPSCounter() = default;
-    void tick();
+    void tick(const FrameRecorder& frames);
 
 private:
     Timer   m_timer;
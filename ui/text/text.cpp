@@ -1,19 +1,131 @@
 #include "text.h"
 #include "font.h"
 
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+
+#include "graphics/glstate.h"
+#include "utils/profiler.h"
+
+namespace
+{
+// Next code point of a UTF-8 string, malformed sequences come out as U+FFFD
+uint32_t decodeUtf8(const std::string& text, size_t& i)
+{
+    constexpr uint32_t Replacement = 0xfffd;
+    unsigned char lead = text[i++];
+    if (lead < 0x80)
+        return lead;
+
+    int extra;
+    uint32_t codepoint;
+    if ((lead & 0xe0) == 0xc0)      { extra = 1; codepoint = lead & 0x1f; }
+    else if ((lead & 0xf0) == 0xe0) { extra = 2; codepoint = lead & 0x0f; }
+    else if ((lead & 0xf8) == 0xf0) { extra = 3; codepoint = lead & 0x07; }
+    else
+        return Replacement;
+
+    for (int k = 0; k < extra; k++, i++)
+    {
+        if (i >= text.size() || (text[i] & 0xc0) != 0x80)
+            return Replacement;
+        codepoint = (codepoint << 6) | (text[i] & 0x3f);
+    }
+    return codepoint;
+}
+}
 
 Text::Text(Font* font, const std::string& text)
     : m_font(font), m_text(text)
 {
 }
 
+Text::~Text()
+{
+    GLState::deleteBuffer(m_vbo);
+    GLState::deleteVertexArray(m_vao);
+}
+
 void Text::render()
 {
-    if (m_font)
+    PROFILE_ZONE("Text::render");
+    if (!m_font || m_text.empty())
+        return;
+    if (m_dirty || m_generation != m_font->generation())
+        build();
+    if (m_vertexCount > 0)
+        m_font->draw(m_vao, m_vertexCount, m_color);
+}
+
+void Text::build()
+{
+    PROFILE_ZONE("Text::build");
+    if (!m_vao)
     {
-        m_font->setColor(m_color);
-        m_font->renderText(m_text, m_px, m_py);
+        glGenVertexArrays(1, &m_vao);
+        glGenBuffers(1, &m_vbo);
+        GLState::bindVertexArray(m_vao);
+        GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(0);
     }
+
+    static std::vector<float> vertices;
+    do
+    {
+        // a glyph that doesn't fit makes the font rebuild its atlas, which moves all
+        // the others, so lay out again
+        m_generation = m_font->generation();
+        vertices.clear();
+
+        float x = m_px, y = m_py;
+        for (size_t i = 0; i < m_text.size();)
+        {
+            uint32_t c = decodeUtf8(m_text, i);
+            if (c == '\n')
+            {
+                x = m_px;
+                y += m_font->size();
+                continue;
+            }
+            const Font::Glyph& g = m_font->glyph(c);
+            if (g.width > 0 && g.height > 0)
+            {
+                float x0 = x + g.left, y0 = y - g.top;
+                float x1 = x0 + g.width, y1 = y0 + g.height;
+                vertices.insert(vertices.end(), {
+                    /* position | texture coord */
+                    x0, y0, g.u0, g.v0,
+                    x0, y1, g.u0, g.v1,
+                    x1, y0, g.u1, g.v0,
+                    x1, y0, g.u1, g.v0,
+                    x0, y1, g.u0, g.v1,
+                    x1, y1, g.u1, g.v1,
+                });
+            }
+            x += g.advance;
+        }
+    } while (m_generation != m_font->generation());
+
+    m_vertexCount = vertices.size() / 4;
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    m_dirty = false;
+}
+
+void Text::setText(const std::string& text)
+{
+    if (text == m_text)
+        return;
+    m_text = text;
+    m_dirty = true;
+}
+
+void Text::setFont(Font* font)
+{
+    m_font = font;
+    m_dirty = true;
 }
 
 void Text::setColor(float r, float g, float b)
@@ -24,4 +136,5 @@ void Text::setColor(float r, float g, float b)
 void Text::setPosition(float px, float py)
 {
     m_px = px; m_py = py;
+    m_dirty = true;
 }
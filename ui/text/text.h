@@ -3,31 +3,44 @@
 
 #include <string>
 
+#include "utils/noncopyable.h"
+
 class Font;
 
-class Text
+// A string laid out once into its own vertex buffer; drawn with a single call and
+// laid out again only when the string, position or font atlas change
+class Text : NonCopyable
 {
 public:
     Text() = default;
     Text(Font* font, const std::string& text = "Sample Text.");
+    ~Text();
 
     void setColor(float r, float g, float b);
     void setPosition(float px, float py);
 
-    void setText(const std::string& text) {m_text = text;}
+    void setText(const std::string& text);
     std::string getText() const           {return m_text;}
 
-    void setFont(Font* font)    {m_font = font;}
+    void setFont(Font* font);
     const Font* getFont() const {return m_font;}
 
     void render();
 
+private:
+    void build();
+
 private:
     Font*       m_font      {nullptr};
-    std::string m_text      {"Sample Text."};
-    float       m_color[3]  {0, 0, 0};
+    std::string m_text      {"Sample Text."}; // UTF-8
+    float       m_color[4]  {0, 0, 0, 1};
     float       m_px         {0.0f},
-                m_py         {0.0f};
+                m_py         {0.0f};   // baseline of the first line
+
+    unsigned    m_vao {0}, m_vbo {0};
+    int         m_vertexCount {0};
+    bool        m_dirty {true};
+    unsigned    m_generation {0};   // of the font atlas the vertices were built for
 };
 
 #endif // TEXT_H
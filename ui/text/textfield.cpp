@@ -19,9 +19,9 @@ void TextField::setPosition(float px, float py)
     m_text.setPosition(px, py);
 }
 
-void TextField::setContext(GLFWwindow* context)
+void TextField::setViewportSize(int width, int height)
 {
-    m_font.setContext(context);
+    m_font.setViewportSize(width, height);
 }
 
 void TextField::setString(const std::string& str)
@@ -14,7 +14,7 @@ public:
     virtual ~TextField();
 
     void setPosition(float px, float py);
-    void setContext(GLFWwindow* context);
+    void setViewportSize(int width, int height);
     void setString(const std::string& str);
     std::string string() const;
     void render();
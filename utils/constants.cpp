@@ -3,6 +3,9 @@
 namespace Consts
 {
     const double FIXED_TIMESTEP = 1.0 / 60;
+    const int    MAX_STEPS_PER_FRAME = 4;
+    const float  GRAVITY = 0.75f;
+    const float  WALK_SPEED = 10;
 }
 
 namespace ShaderFiles
@@ -4,6 +4,9 @@
 namespace Consts
 {
     extern const double FIXED_TIMESTEP;
+    extern const int    MAX_STEPS_PER_FRAME;
+    extern const float  GRAVITY; // vertical velocity (blocks per tick) lost per second, for the player and entities alike
+    extern const float  WALK_SPEED; // blocks per second
 }
 
 namespace ShaderFiles
@@ -6,6 +6,10 @@ namespace DrawCallTrack
 {
 int drawCallCount;
 int triangleCount;
+int uniformSetCount;
+int redundantUniformSetCount;
+int stateChangeCount;
+int skippedStateChangeCount;
 int getDrawCallCount()
 {
     return drawCallCount;
@@ -14,18 +18,59 @@ int getTriangleCount()
 {
     return triangleCount;
 }
+int getUniformSetCount()
+{
+    return uniformSetCount;
+}
+int getRedundantUniformSetCount()
+{
+    return redundantUniformSetCount;
+}
+int getStateChangeCount()
+{
+    return stateChangeCount;
+}
+int getSkippedStateChangeCount()
+{
+    return skippedStateChangeCount;
+}
 void resetCount()
 {
     drawCallCount = 0;
     triangleCount = 0;
+    uniformSetCount = 0;
+    redundantUniformSetCount = 0;
+    stateChangeCount = 0;
+    skippedStateChangeCount = 0;
 }
-void glDrawArrays_track(unsigned mode, int index, int count)
+void countUniformSet(bool redundant)
+{
+    uniformSetCount++;
+    redundantUniformSetCount += redundant;
+}
+void countStateChange(bool skipped)
+{
+    stateChangeCount += !skipped;
+    skippedStateChangeCount += skipped;
+}
+static int trianglesIn(unsigned mode, int count)
 {
-    drawCallCount++;
     if (mode == GL_TRIANGLES)
-        triangleCount += count / 3;
+        return count / 3;
     else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
-        triangleCount += count - 2;
+        return count - 2;
+    return 0;
+}
+void glDrawArrays_track(unsigned mode, int index, int count)
+{
+    drawCallCount++;
+    triangleCount += trianglesIn(mode, count);
     glad_glDrawArrays(mode, index, count);
 }
+void glDrawArraysInstanced_track(unsigned mode, int index, int count, int instances)
+{
+    drawCallCount++;
+    triangleCount += trianglesIn(mode, count) * instances;
+    glad_glDrawArraysInstanced(mode, index, count, instances);
+}
 }
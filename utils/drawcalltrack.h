@@ -5,16 +5,27 @@
 
 #ifdef TRACK_GL_DRAWCALLS
     #define glDrawArrays_(mode, index, count) DrawCallTrack::glDrawArrays_track(mode, index, count)
+    #define glDrawArraysInstanced_(mode, index, count, instances) \
+        DrawCallTrack::glDrawArraysInstanced_track(mode, index, count, instances)
 #else
     #define glDrawArrays_(mode, index, count) glad_glDrawArrays(mode, index, count)
+    #define glDrawArraysInstanced_(mode, index, count, instances) \
+        glad_glDrawArraysInstanced(mode, index, count, instances)
 #endif
 
 namespace DrawCallTrack
 {
 int getDrawCallCount();
 int getTriangleCount();
+int getUniformSetCount();
+int getRedundantUniformSetCount();
+int getStateChangeCount();
+int getSkippedStateChangeCount();
 void resetCount();
+void countUniformSet(bool redundant);
+void countStateChange(bool skipped);
 void glDrawArrays_track(unsigned mode, int index, int count);
+void glDrawArraysInstanced_track(unsigned mode, int index, int count, int instances);
 }
 
 #endif // DRAWCALLTRACK_H_INCLUDED
@@ -0,0 +1,52 @@
+#include "framebudget.h"
+
+#include <algorithm>
+
+constexpr double growRate = 0.1; // fraction of the difference regained per frame
+
+FrameBudget::FrameBudget(double minSecs, double maxSecs)
+{
+    setLimits(minSecs, maxSecs);
+    m_budget = m_min;
+}
+
+void FrameBudget::setLimits(double minSecs, double maxSecs)
+{
+    m_min = minSecs;
+    m_max = std::max(minSecs, maxSecs);
+}
+
+void FrameBudget::setUnlimited(bool unlimited)
+{
+    m_unlimited = unlimited;
+}
+
+void FrameBudget::beginFrame(double targetFrameSecs, double lastFrameSecs)
+{
+    // time the rest of the frame (physics, rendering, swap) took without us
+    double otherWork = std::max(0.0, lastFrameSecs - m_spent);
+    double available = std::clamp(targetFrameSecs - otherWork, m_min, m_max);
+
+    if (available < m_budget)
+        m_budget = available;
+    else
+        m_budget += (available - m_budget) * growRate;
+
+    m_spentLastFrame = m_spent;
+    m_spent = 0;
+}
+
+void FrameBudget::startTask()
+{
+    m_taskTimer.restart();
+}
+
+void FrameBudget::finishTask()
+{
+    m_spent += m_taskTimer.getElapsedSecs();
+}
+
+bool FrameBudget::hasTime(double share) const
+{
+    return m_unlimited || m_spent < m_budget * share;
+}
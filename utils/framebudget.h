@@ -0,0 +1,41 @@
+#ifndef FRAMEBUDGET_H
+#define FRAMEBUDGET_H
+
+#include "timer.h"
+
+/*
+    Per-frame time budget for streaming work (column loads, remeshes, VBO uploads).
+    The budget is whatever is left of the target frame time after everything else
+    the previous frame did, clamped to [min, max]. It shrinks at once when frames
+    get expensive and grows back gradually when they are cheap.
+*/
+class FrameBudget
+{
+public:
+    FrameBudget(double minSecs = 0.001, double maxSecs = 0.008);
+
+    void setLimits(double minSecs, double maxSecs);
+    // hasTime is always true, for runs that have to stream the same on any machine
+    void setUnlimited(bool unlimited);
+    void beginFrame(double targetFrameSecs, double lastFrameSecs);
+
+    void startTask();
+    void finishTask();
+
+    // true while less than (share * budget) has been spent this frame
+    bool hasTime(double share = 1.0) const;
+
+    double getBudgetSecs() const            {return m_budget;}
+    double getSpentSecs() const             {return m_spent;}
+    double getSpentLastFrameSecs() const    {return m_spentLastFrame;}
+
+private:
+    Timer   m_taskTimer;
+    double  m_min, m_max;
+    bool    m_unlimited {false};
+    double  m_budget;
+    double  m_spent {0},
+            m_spentLastFrame {0};
+};
+
+#endif // FRAMEBUDGET_H
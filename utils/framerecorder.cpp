@@ -0,0 +1,159 @@
+#include "framerecorder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+constexpr size_t MaxLogged = 1 << 20; // a few hours; later frames only reach the window
+
+FrameRecorder::FrameRecorder(float hitchMs)
+    : m_hitchMs(hitchMs)
+{
+    m_log.reserve(1 << 14);
+}
+
+void FrameRecorder::setHitchThreshold(float ms)
+{
+    m_hitchMs = ms;
+}
+
+void FrameRecorder::record(double cpuSecs, double sleepSecs)
+{
+    Frame frame {(float)m_time, (float)(cpuSecs * 1000), (float)(sleepSecs * 1000)};
+    m_time += cpuSecs + sleepSecs;
+
+    if (frame.totalMs() > m_hitchMs)
+        m_hitches++;
+
+    if (m_windowCount == WindowSize)
+    {
+        const Frame& oldest = m_window[m_next];
+        m_frameHistogram.add(oldest.totalMs(), -1);
+        m_cpuHistogram.add(oldest.cpuMs, -1);
+    }
+    else
+        m_windowCount++;
+
+    m_window[m_next] = frame;
+    m_next = (m_next + 1) % WindowSize;
+    m_frameHistogram.add(frame.totalMs(), 1);
+    m_cpuHistogram.add(frame.cpuMs, 1);
+
+    if (m_log.size() < MaxLogged)
+        m_log.push_back(frame);
+}
+
+void FrameRecorder::Histogram::add(float ms, int delta)
+{
+    int bucket = std::clamp((int)(ms / BucketMs), 0, BucketCount - 1);
+    buckets[bucket] += delta;
+    count += delta;
+}
+
+FrameRecorder::Summary FrameRecorder::Histogram::summary(float max) const
+{
+    Summary s;
+    s.max = max;
+    if (count == 0)
+        return s;
+
+    // upper edge of the bucket holding the percentile, the max caps the overflow bucket
+    auto percentile = [&](float p)
+    {
+        int rank = std::max(1, (int)(p * count + 0.5f));
+        int seen = 0;
+        for (int i = 0; i < BucketCount; i++)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+                return std::min((i + 1) * BucketMs, max);
+        }
+        return max;
+    };
+    s.p50 = percentile(0.50f);
+    s.p95 = percentile(0.95f);
+    s.p99 = percentile(0.99f);
+    return s;
+}
+
+FrameRecorder::Summary FrameRecorder::getFrameSummary() const
+{
+    float max = 0;
+    for (int i = 0; i < m_windowCount; i++)
+        max = std::max(max, m_window[i].totalMs());
+    return m_frameHistogram.summary(max);
+}
+
+FrameRecorder::Summary FrameRecorder::getCpuSummary() const
+{
+    float max = 0;
+    for (int i = 0; i < m_windowCount; i++)
+        max = std::max(max, m_window[i].cpuMs);
+    return m_cpuHistogram.summary(max);
+}
+
+FrameRecorder::Summary FrameRecorder::getRunFrameSummary() const
+{
+    std::vector<float> values;
+    values.reserve(m_log.size());
+    for (const Frame& f : m_log)
+        values.push_back(f.totalMs());
+    return summarize(std::move(values));
+}
+
+FrameRecorder::Summary FrameRecorder::getRunCpuSummary() const
+{
+    std::vector<float> values;
+    values.reserve(m_log.size());
+    for (const Frame& f : m_log)
+        values.push_back(f.cpuMs);
+    return summarize(std::move(values));
+}
+
+FrameRecorder::Summary FrameRecorder::summarize(std::vector<float> values)
+{
+    Summary s;
+    if (values.empty())
+        return s;
+
+    // nearest rank
+    std::sort(values.begin(), values.end());
+    auto percentile = [&](float p)
+    {
+        size_t rank = std::max<size_t>(1, (size_t)(p * values.size() + 0.5f));
+        return values[std::min(rank, values.size()) - 1];
+    };
+    s.p50 = percentile(0.50f);
+    s.p95 = percentile(0.95f);
+    s.p99 = percentile(0.99f);
+    s.max = values.back();
+    return s;
+}
+
+int FrameRecorder::getRecentCount() const
+{
+    return m_windowCount;
+}
+
+const FrameRecorder::Frame& FrameRecorder::getRecent(int i) const
+{
+    int oldest = m_windowCount == WindowSize ? m_next : 0;
+    return m_window[(oldest + i) % WindowSize];
+}
+
+bool FrameRecorder::writeCsv(const std::string& file) const
+{
+    std::ofstream out(file);
+    if (!out)
+        return false;
+
+    out << "frame,time_s,cpu_ms,sleep_ms,frame_ms,hitch\n";
+    out << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < m_log.size(); i++)
+    {
+        const Frame& f = m_log[i];
+        out << i << ',' << f.time << ',' << f.cpuMs << ',' << f.sleepMs << ','
+            << f.totalMs() << ',' << (f.totalMs() > m_hitchMs ? 1 : 0) << '\n';
+    }
+    return true;
+}
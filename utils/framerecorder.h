@@ -0,0 +1,79 @@
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+/*
+    Frame times split into CPU work and the fps limiter's sleep. The last
+    WindowSize frames feed a histogram for percentiles and the on-screen graph;
+    every frame is also logged for the CSV.
+*/
+class FrameRecorder
+{
+public:
+    static constexpr int WindowSize = 1024;
+
+    struct Frame
+    {
+        float   time;       // secs since the first frame
+        float   cpuMs;
+        float   sleepMs;
+
+        float   totalMs() const {return cpuMs + sleepMs;}
+    };
+
+    struct Summary
+    {
+        float   p50 {0}, p95 {0}, p99 {0}, max {0};
+    };
+
+    FrameRecorder(float hitchMs = 33);
+
+    void setHitchThreshold(float ms);
+    float getHitchThreshold() const         {return m_hitchMs;}
+
+    void record(double cpuSecs, double sleepSecs);
+
+    // over the window, at histogram resolution except for the max
+    Summary getFrameSummary() const;
+    Summary getCpuSummary() const;
+    int getHitchCount() const               {return m_hitches;}
+
+    // exact, over every logged frame
+    Summary getRunFrameSummary() const;
+    Summary getRunCpuSummary() const;
+    int getLoggedCount() const              {return m_log.size();}
+    static Summary summarize(std::vector<float> values);
+
+    // i = 0 is the oldest of the last recentCount() frames
+    int getRecentCount() const;
+    const Frame& getRecent(int i) const;
+
+    bool writeCsv(const std::string& file) const;
+
+private:
+    static constexpr float BucketMs = 0.25f;
+    static constexpr int BucketCount = 400;         // last one also takes everything above
+
+    struct Histogram
+    {
+        std::array<int, BucketCount> buckets {};
+        int count {0};
+
+        void add(float ms, int delta);
+        Summary summary(float max) const;
+    };
+
+private:
+    float                       m_hitchMs;
+    int                         m_hitches {0};
+    double                      m_time {0};
+    std::array<Frame, WindowSize> m_window;
+    int                         m_next {0}, m_windowCount {0};
+    Histogram                   m_frameHistogram, m_cpuHistogram;
+    std::vector<Frame>          m_log;
+};
+
+#endif // FRAMERECORDER_H
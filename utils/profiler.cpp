@@ -0,0 +1,159 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+std::atomic<bool> Profiler::s_enabled {false};
+
+struct Profiler::ThreadBuffer
+{
+    static constexpr uint32_t Size = 1 << 14; // power of two
+
+    std::array<Event, Size> events;
+    std::atomic<uint32_t>   head {0};   // events written so far, only the owner writes
+    uint32_t                read {0};   // what endFrame has seen, main thread only
+    int                     depth {0};  // owner only
+    int                     id {0};
+    std::string             name;
+};
+
+thread_local Profiler::ThreadBuffer* Profiler::t_buffer = nullptr;
+thread_local std::string Profiler::t_name;
+
+Profiler& Profiler::get()
+{
+    static Profiler instance;
+    return instance;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+    if (!enabled)
+        m_stats.clear();
+}
+
+Profiler::ThreadBuffer& Profiler::buffer()
+{
+    if (!t_buffer)
+    {
+        // once per thread; buffers outlive their threads so that the trace keeps them
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.emplace_back(std::make_unique<ThreadBuffer>());
+        t_buffer = m_buffers.back().get();
+        t_buffer->id = m_buffers.size();
+        t_buffer->name = t_name.empty() ? "thread " + std::to_string(t_buffer->id) : t_name;
+    }
+    return *t_buffer;
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+    t_name = name;
+    if (!t_buffer)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    t_buffer->name = name;
+}
+
+int Profiler::beginZone()
+{
+    return buffer().depth++;
+}
+
+void Profiler::endZone(const char* name, double start, int depth)
+{
+    ThreadBuffer& b = buffer();
+    b.depth = depth;
+    uint32_t head = b.head.load(std::memory_order_relaxed);
+    b.events[head & (ThreadBuffer::Size - 1)] = {name, start, now(), depth};
+    b.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::endFrame()
+{
+    if (!isEnabled())
+        return;
+
+    for (ZoneStat& s : m_stats)
+        s.ms *= 0.9f, s.calls *= 0.9f;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& b : m_buffers)
+    {
+        uint32_t head = b->head.load(std::memory_order_acquire);
+        uint32_t from = std::max(b->read, head > ThreadBuffer::Size ? head - ThreadBuffer::Size : 0);
+        for (uint32_t i = from; i < head; i++)
+        {
+            const Event& e = b->events[i & (ThreadBuffer::Size - 1)];
+            auto it = std::find_if(m_stats.begin(), m_stats.end(),
+                                   [&e](const ZoneStat& s) { return s.name == e.name; });
+            if (it == m_stats.end())
+            {
+                m_stats.push_back({e.name, 0, 0, e.depth});
+                it = m_stats.end() - 1;
+            }
+            it->ms += (e.end - e.start) * 1000 * 0.1f;
+            it->calls += 0.1f;
+            it->depth = std::min(it->depth, e.depth);
+        }
+        b->read = head;
+    }
+
+    m_stats.erase(std::remove_if(m_stats.begin(), m_stats.end(),
+                                 [](const ZoneStat& s) { return s.calls < 0.01f; }), m_stats.end());
+    std::sort(m_stats.begin(), m_stats.end(),
+              [](const ZoneStat& a, const ZoneStat& b) { return a.ms > b.ms; });
+}
+
+const std::vector<Profiler::ZoneStat>& Profiler::getFrameStats() const
+{
+    return m_stats;
+}
+
+// Workers may overwrite old events while this runs, the trace is a best effort snapshot
+bool Profiler::writeChromeTrace(const std::string& file, const std::vector<Event>& extra,
+                                const std::string& extraName) const
+{
+    std::ofstream out(file);
+    if (!out)
+        return false;
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto write = [&](const Event& e, int tid)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << e.start * 1e6 << ",\"dur\":" << (e.end - e.start) * 1e6 << '}';
+        first = false;
+    };
+    auto writeName = [&](int tid, const std::string& name)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << name << "\"}}";
+        first = false;
+    };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& b : m_buffers)
+    {
+        writeName(b->id, b->name);
+        uint32_t head = b->head.load(std::memory_order_acquire);
+        uint32_t from = head > ThreadBuffer::Size ? head - ThreadBuffer::Size : 0;
+        for (uint32_t i = from; i < head; i++)
+            write(b->events[i & (ThreadBuffer::Size - 1)], b->id);
+    }
+    if (!extra.empty())
+    {
+        int tid = m_buffers.size() + 1;
+        writeName(tid, extraName);
+        for (const Event& e : extra)
+            write(e, tid);
+    }
+    out << "\n]}\n";
+    return true;
+}
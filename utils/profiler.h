@@ -0,0 +1,116 @@
+#ifndef PROFILER_H_INCLUDED
+#define PROFILER_H_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _GLIBCXX_HAS_GTHREADS
+#include <mingw.mutex.h>
+#else
+#include <mutex>
+#endif
+
+#include "noncopyable.h"
+#include "timer.h"
+
+#define PROFILE_ZONES
+
+#ifdef PROFILE_ZONES
+    #define PROFILE_CONCAT_(a, b) a##b
+    #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+    // times the rest of the enclosing scope, name must be a string literal
+    #define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#else
+    #define PROFILE_ZONE(name)
+#endif
+
+/*
+    Scoped CPU zones. Every thread records the zones it finishes into a ring buffer
+    of its own, without locks; the main thread sums them up once per frame and can
+    write what the buffers still hold as a Chrome trace (chrome://tracing, Perfetto).
+    While disabled a zone costs one relaxed atomic load.
+*/
+class Profiler : NonCopyable
+{
+public:
+    struct Event
+    {
+        const char* name;
+        double      start, end;     // seconds since the profiler was created
+        int         depth;          // nesting level on its thread
+    };
+
+    struct ZoneStat
+    {
+        std::string name;
+        float       ms {0};         // per frame, smoothed
+        float       calls {0};
+        int         depth {0};
+    };
+
+    static Profiler& get();
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    void        setEnabled(bool enabled);
+
+    // shown in the trace, call from the thread itself; the buffer is only
+    // allocated once the thread records a zone
+    void        setThreadName(const std::string& name);
+
+    // collects the zones finished since the last call; main thread, once per frame
+    void        endFrame();
+    // zones sorted by time spent in them
+    const std::vector<ZoneStat>& getFrameStats() const;
+
+    // events still in the ring buffers, plus extra ones (e.g. GPU timings) on their own track
+    bool        writeChromeTrace(const std::string& file, const std::vector<Event>& extra = {},
+                                 const std::string& extraName = "") const;
+
+    double      now() const { return m_clock.getElapsedSecs(); }
+    int         beginZone();
+    void        endZone(const char* name, double start, int depth);
+
+private:
+    struct ThreadBuffer;
+
+    Profiler() = default;
+    ThreadBuffer& buffer();
+
+private:
+    static std::atomic<bool>    s_enabled;
+    static thread_local ThreadBuffer* t_buffer;
+    static thread_local std::string t_name;     // until the thread records a zone
+
+    Timer                       m_clock;
+    mutable std::mutex          m_mutex;    // guards m_buffers, not their contents
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::vector<ZoneStat>       m_stats;
+};
+
+class ProfileZone : NonCopyable
+{
+public:
+    explicit ProfileZone(const char* name)
+    {
+        if (Profiler::isEnabled())
+        {
+            m_name = name;
+            m_depth = Profiler::get().beginZone();
+            m_start = Profiler::get().now();
+        }
+    }
+    ~ProfileZone()
+    {
+        if (m_name)
+            Profiler::get().endZone(m_name, m_start, m_depth);
+    }
+
+private:
+    const char* m_name {nullptr};
+    double      m_start {0};
+    int         m_depth {0};
+};
+
+#endif // PROFILER_H_INCLUDED
@@ -0,0 +1,98 @@
+#include "threadpool.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    for (unsigned i = 0; i < threads; i++)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : m_workers)
+        t.join();
+}
+
+ThreadPool& ThreadPool::get()
+{
+    // leave one core to the main (GL) thread
+    static ThreadPool instance {std::max(2u, std::thread::hardware_concurrency()) - 1};
+    return instance;
+}
+
+unsigned ThreadPool::size() const
+{
+    return m_workers.size();
+}
+
+void ThreadPool::submit(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    Profiler::get().setThreadName("worker");
+
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& fn)
+{
+    if (count <= 0)
+        return;
+
+    int slices = std::min<int>(count, m_workers.size() + 1);
+    int sliceSize = (count + slices - 1) / slices;
+
+    if (slices == 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    int pending = slices - 1;
+
+    for (int s = 1; s < slices; s++)
+    {
+        int begin = s * sliceSize;
+        int end = std::min(count, begin + sliceSize);
+        submit([&, begin, end]
+        {
+            if (begin < end)
+                fn(begin, end);
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--pending == 0)
+                doneCv.notify_one();
+        });
+    }
+    fn(0, std::min(count, sliceSize));
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCv.wait(lock, [&]{ return pending == 0; });
+}
@@ -0,0 +1,50 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <functional>
+#include <vector>
+#include <deque>
+
+#ifndef _GLIBCXX_HAS_GTHREADS
+#include <mingw.thread.h>
+#include <mingw.mutex.h>
+#include <mingw.condition_variable.h>
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#include "noncopyable.h"
+
+// Fixed set of worker threads shared by background jobs (entities, block simulation)
+class ThreadPool : NonCopyable
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    static ThreadPool& get();
+
+    void submit(Task task);
+
+    // Calls fn(begin, end) for slices of [0, count) on the workers and on the calling
+    // thread, returns when all of them are done
+    void parallelFor(int count, const std::function<void(int, int)>& fn);
+
+    unsigned size() const;
+
+private:
+    void workerLoop();
+
+private:
+    std::vector<std::thread>    m_workers;
+    std::deque<Task>            m_tasks;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_cv;
+    bool                        m_stop {false};
+};
+
+#endif // THREADPOOL_H
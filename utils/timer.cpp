@@ -25,7 +25,7 @@ LARGE_INTEGER& Timer::freq()
 }
 #endif
 
-double Timer::getElapsedSecs()
+double Timer::getElapsedSecs() const
 {
 #ifdef WIN
     LARGE_INTEGER end, elapsed;
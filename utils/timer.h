@@ -19,12 +19,12 @@ class Timer
 {
 public:
     Timer();
-    double getElapsedSecs();
+    double getElapsedSecs() const;
     void restart();
 
 private:
 #ifdef WIN
-    LARGE_INTEGER& freq();
+    static LARGE_INTEGER& freq();
 #endif
     TimePoint m_start;
 };
@@ -4,6 +4,12 @@
 #include <fstream>
 #include <sstream>
 
+#ifdef _WIN32
+    #define PSAPI_VERSION 2 // lives in kernel32, no psapi.lib needed
+    #include <windows.h>
+    #include <psapi.h>
+#endif
+
 namespace Utils
 {
     std::string getTextFromFile(const char * file)
@@ -49,4 +55,21 @@ namespace Utils
         }
         return errorCode;
     }
+
+    size_t getPeakMemoryBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof counters))
+            return counters.PeakWorkingSetSize;
+        return 0;
+#else
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+            if (line.compare(0, 6, "VmHWM:") == 0)
+                return std::stoull(line.substr(6)) * 1024; // reported in kB
+        return 0;
+#endif
+    }
 }
@@ -14,6 +14,8 @@ namespace Utils
 {
     std::string getTextFromFile(const char * file);
     GLenum glCheckError_(const char * file, const char * func, int line);
+    // high-water mark of the resident set, 0 where it can't be read
+    size_t getPeakMemoryBytes();
 }
 
 #endif // UTILS_H_INCLUDED